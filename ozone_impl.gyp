@@ -28,14 +28,20 @@
       'sources': [
         'media/media_ozone_platform_wayland.cc',
         'media/media_ozone_platform_wayland.h',
+        'platform/bitmap_cursor_factory_wayland.cc',
+        'platform/bitmap_cursor_factory_wayland.h',
 	'platform/client_native_pixmap_factory_wayland.cc',
 	'platform/client_native_pixmap_factory_wayland.h',
         'platform/desktop_platform_screen.h',
 	'platform/desktop_platform_screen_delegate.h',
+        'platform/input_event_ring.cc',
+        'platform/input_event_ring.h',
         'platform/ozone_export_wayland.h',
 	'platform/messages.h',
 	'platform/message_generator.h',
 	'platform/message_generator.cc',
+        'platform/overlay_manager_wayland.cc',
+        'platform/overlay_manager_wayland.h',
 	'platform/ozone_gpu_platform_support_host.h',
 	'platform/ozone_gpu_platform_support_host.cc',
         'platform/ozone_platform_wayland.cc',
@@ -44,6 +50,8 @@
         'platform/ozone_wayland_seat.h',
         'platform/ozone_wayland_window.cc',
         'platform/ozone_wayland_window.h',
+        'platform/surface_ozone_canvas_host.cc',
+        'platform/surface_ozone_canvas_host.h',
 	'platform/window_constants.h',
         'platform/window_manager_wayland.cc',
         'platform/window_manager_wayland.h',
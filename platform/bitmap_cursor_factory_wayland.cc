@@ -0,0 +1,40 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/bitmap_cursor_factory_wayland.h"
+
+#include "ui/base/cursor/cursor.h"
+
+namespace ui {
+
+BitmapCursorFactoryWayland::BitmapCursorFactoryWayland() {
+}
+
+BitmapCursorFactoryWayland::~BitmapCursorFactoryWayland() {
+}
+
+int BitmapCursorFactoryWayland::GetCursorType(PlatformCursor cursor) const {
+  std::map<PlatformCursor, int>::const_iterator it =
+      default_cursor_types_.find(cursor);
+  return it != default_cursor_types_.end() ? it->second : kCursorCustom;
+}
+
+PlatformCursor BitmapCursorFactoryWayland::GetDefaultCursor(int type) {
+  PlatformCursor cursor = BitmapCursorFactoryOzone::GetDefaultCursor(type);
+  if (!cursor)
+    return cursor;
+
+  std::map<PlatformCursor, int>::iterator it =
+      default_cursor_types_.find(cursor);
+  if (it == default_cursor_types_.end()) {
+    default_cursor_types_[cursor] = type;
+  } else if (it->second != type) {
+    // The types without a bitmap of their own share the pointer.
+    it->second = kCursorPointer;
+  }
+
+  return cursor;
+}
+
+}  // namespace ui
@@ -0,0 +1,39 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_IMPL_PLATFORM_BITMAP_CURSOR_FACTORY_WAYLAND_H_
+#define OZONE_IMPL_PLATFORM_BITMAP_CURSOR_FACTORY_WAYLAND_H_
+
+#include <map>
+
+#include "base/macros.h"
+#include "ui/base/cursor/ozone/bitmap_cursor_factory_ozone.h"
+
+namespace ui {
+
+// Remembers the type of the default cursors, so that the ones the cursor
+// theme of the GPU process provides are shown from the theme instead of
+// uploading their bitmaps.
+class BitmapCursorFactoryWayland : public BitmapCursorFactoryOzone {
+ public:
+  BitmapCursorFactoryWayland();
+  ~BitmapCursorFactoryWayland() override;
+
+  // Returns the type (ui::CursorType) |cursor| was created for, kCursorCustom
+  // if it isn't a default cursor.
+  int GetCursorType(PlatformCursor cursor) const;
+
+  // BitmapCursorFactoryOzone:
+  PlatformCursor GetDefaultCursor(int type) override;
+
+ private:
+  // Default cursors are kept by the base class forever, so they can be told
+  // apart by their address.
+  std::map<PlatformCursor, int> default_cursor_types_;
+  DISALLOW_COPY_AND_ASSIGN(BitmapCursorFactoryWayland);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_IMPL_PLATFORM_BITMAP_CURSOR_FACTORY_WAYLAND_H_
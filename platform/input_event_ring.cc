@@ -0,0 +1,105 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/input_event_ring.h"
+
+#include "base/logging.h"
+
+namespace ui {
+
+InputEventRing::InputEventRing()
+    : header_(NULL),
+      slots_(NULL),
+      capacity_(0),
+      corrupted_(false) {
+}
+
+InputEventRing::~InputEventRing() {
+}
+
+// static
+size_t InputEventRing::RequiredSize(uint32_t capacity) {
+  return sizeof(Header) + capacity * sizeof(Slot);
+}
+
+bool InputEventRing::Attach(void* memory, size_t size, bool initialize) {
+  DCHECK(!header_);
+  if (size < sizeof(Header))
+    return false;
+
+  Header* header = static_cast<Header*>(memory);
+  uint32_t capacity = (size - sizeof(Header)) / sizeof(Slot);
+  if (initialize) {
+    header->capacity = capacity;
+    base::subtle::NoBarrier_Store(&header->read_index, 0);
+    base::subtle::Release_Store(&header->write_index, 0);
+  }
+
+  // The capacity is read once, the other side could change it afterwards.
+  if (!capacity || header->capacity != capacity)
+    return false;
+
+  header_ = header;
+  slots_ = reinterpret_cast<Slot*>(header + 1);
+  capacity_ = capacity;
+  corrupted_ = false;
+  return true;
+}
+
+void InputEventRing::Detach() {
+  header_ = NULL;
+  slots_ = NULL;
+  capacity_ = 0;
+}
+
+bool InputEventRing::Push(const std::vector<InputEventRecord>& events,
+                          uint32_t sequence) {
+  DCHECK(header_);
+  uint32_t write =
+      base::subtle::NoBarrier_Load(&header_->write_index);
+  uint32_t read = base::subtle::Acquire_Load(&header_->read_index);
+  if (capacity_ - (write - read) < events.size())
+    return false;
+
+  for (const InputEventRecord& event : events) {
+    Slot* slot = &slots_[write % capacity_];
+    slot->sequence = sequence;
+    slot->event = event;
+    write++;
+  }
+
+  base::subtle::Release_Store(&header_->write_index, write);
+  return true;
+}
+
+bool InputEventRing::Pop(uint32_t max_sequence,
+                         InputEventRecord* event,
+                         uint32_t* sequence) {
+  DCHECK(header_);
+  if (corrupted_)
+    return false;
+
+  uint32_t read = base::subtle::NoBarrier_Load(&header_->read_index);
+  uint32_t write = base::subtle::Acquire_Load(&header_->write_index);
+  if (read == write)
+    return false;
+
+  // The producer lives in another process, don't trust its indices.
+  if (write - read > capacity_) {
+    LOG(ERROR) << "Input event ring indices are corrupted.";
+    corrupted_ = true;
+    return false;
+  }
+
+  const Slot* slot = &slots_[read % capacity_];
+  if (static_cast<int32_t>(slot->sequence - max_sequence) > 0)
+    return false;
+
+  *event = slot->event;
+  *sequence = slot->sequence;
+  base::subtle::Release_Store(&header_->read_index, read + 1);
+  return true;
+}
+
+}  // namespace ui
@@ -0,0 +1,73 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_INPUT_EVENT_RING_H_
+#define OZONE_PLATFORM_INPUT_EVENT_RING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "ozone/platform/window_constants.h"
+
+namespace ui {
+
+// InputEventRing is a lock-free single producer/single consumer ring of
+// InputEventRecords living in memory shared between the GPU process (the
+// producer) and the browser process (the consumer). Input messages and
+// batches of records share one sequence (see messages.h). Every record carries
+// the sequence number of its batch, so that the browser doesn't handle it
+// before the input messages sent ahead of it.
+class InputEventRing {
+ public:
+  InputEventRing();
+  ~InputEventRing();
+
+  // Returns the size of the memory needed to hold |capacity| records.
+  static size_t RequiredSize(uint32_t capacity);
+
+  // Makes the ring use |memory|, which must stay mapped until Detach is
+  // called. The creator of the ring passes |initialize| to reset the header,
+  // the other side only validates it. Returns false if |size| doesn't match
+  // the header.
+  bool Attach(void* memory, size_t size, bool initialize);
+  void Detach();
+  bool IsAttached() const { return header_ != NULL; }
+
+  // Producer side. Writes all of |events| with |sequence|, or none of them
+  // and returns false if they don't fit.
+  bool Push(const std::vector<InputEventRecord>& events, uint32_t sequence);
+
+  // Consumer side. Pops the oldest record and its sequence number if that is
+  // not greater than |max_sequence|. Returns false if there is nothing to pop
+  // or if the producer corrupted the indices, in which case IsCorrupted
+  // returns true and the ring shouldn't be used anymore.
+  bool Pop(uint32_t max_sequence, InputEventRecord* event, uint32_t* sequence);
+  bool IsCorrupted() const { return corrupted_; }
+
+ private:
+  struct Header {
+    base::subtle::Atomic32 write_index;
+    base::subtle::Atomic32 read_index;
+    uint32_t capacity;
+  };
+
+  struct Slot {
+    uint32_t sequence;
+    InputEventRecord event;
+  };
+
+  Header* header_;
+  Slot* slots_;
+  uint32_t capacity_;
+  bool corrupted_;
+  DISALLOW_COPY_AND_ASSIGN(InputEventRing);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_INPUT_EVENT_RING_H_
@@ -32,64 +32,69 @@ IPC_ENUM_TRAITS_MAX_VALUE(ui::WidgetState,
                           ui::DESTROYED)
 IPC_ENUM_TRAITS_MAX_VALUE(ui::WidgetType,
                           ui::TOOLTIP)
+IPC_ENUM_TRAITS_MAX_VALUE(ui::InputEventKind,
+                          ui::INPUT_MOTION_HISTORY)
 
 IPC_STRUCT_TRAITS_BEGIN(ui::PointerPosition)
   IPC_STRUCT_TRAITS_MEMBER(x)
   IPC_STRUCT_TRAITS_MEMBER(y)
 IPC_STRUCT_TRAITS_END()
 
+IPC_STRUCT_TRAITS_BEGIN(ui::InputEventRecord)
+  IPC_STRUCT_TRAITS_MEMBER(kind)
+  IPC_STRUCT_TRAITS_MEMBER(handle)
+  IPC_STRUCT_TRAITS_MEMBER(type)
+  IPC_STRUCT_TRAITS_MEMBER(flags)
+  IPC_STRUCT_TRAITS_MEMBER(position)
+  IPC_STRUCT_TRAITS_MEMBER(x_offset)
+  IPC_STRUCT_TRAITS_MEMBER(y_offset)
+  IPC_STRUCT_TRAITS_MEMBER(touch_id)
+  IPC_STRUCT_TRAITS_MEMBER(time_stamp)
+  IPC_STRUCT_TRAITS_MEMBER(device_id)
+IPC_STRUCT_TRAITS_END()
+
 //------------------------------------------------------------------------------
 // Browser Messages
 // These messages are from the GPU to the browser process.
+//
+// The input messages carry a sequence number, shared with the batches written
+// to the input ring (see InputEventRing), which tells the browser the order
+// they were read in.
 
 IPC_MESSAGE_CONTROL2(WaylandInput_InitializeXKB,  // NOLINT(readability/fn_size)
                      base::SharedMemoryHandle /*fd*/,
                      uint32_t /*size*/)
 
-IPC_MESSAGE_CONTROL3(WaylandInput_KeyNotify,  // NOLINT(readability/fn_size)
+IPC_MESSAGE_CONTROL4(WaylandInput_KeyNotify,  // NOLINT(readability/fn_size)
                      ui::EventType /*type*/,
                      unsigned /*code*/,
-                     int /*device_id*/)
+                     int /*device_id*/,
+                     uint32_t /*sequence*/)
 
-IPC_MESSAGE_CONTROL3(  // NOLINT(readability/fn_size)
+IPC_MESSAGE_CONTROL4(  // NOLINT(readability/fn_size)
     WaylandInput_VirtualKeyNotify,
     ui::EventType /*type*/,
     uint32_t /*key*/,
-    int /*device_id*/)
-
-IPC_MESSAGE_CONTROL2(WaylandInput_MotionNotify,  // NOLINT(readability/fn_size)
-                     ui::PointerPosition /*x, y*/,
-                     int /*device_id*/)
+    int /*device_id*/,
+    uint32_t /*sequence*/)
 
-IPC_MESSAGE_CONTROL5(WaylandInput_ButtonNotify,  // NOLINT(readability/fn_size)
-                     unsigned /*handle*/,
-                     ui::EventType /*type*/,
-                     ui::EventFlags /*flags*/,
-                     ui::PointerPosition /*x, y*/,
-                     int /*device_id*/)
+// Pointer and touch events accumulated until the end of a wl_touch.frame or
+// of an input dispatch cycle, in the order they were received.
+IPC_MESSAGE_CONTROL2(WaylandInput_EventBatch,  // NOLINT(readability/fn_size)
+                     std::vector<ui::InputEventRecord> /*events*/,
+                     uint32_t /*sequence*/)
 
-IPC_MESSAGE_CONTROL5(WaylandInput_TouchNotify,  // NOLINT(readability/fn_size)
-                     ui::EventType /*type*/,
-                     ui::PointerPosition,
-                     int32_t /*touch_id*/,
-                     uint32_t /*time_stamp*/,
-                     int /*device_id*/)
-
-IPC_MESSAGE_CONTROL4(WaylandInput_AxisNotify,  // NOLINT(readability/fn_size)
-                     ui::PointerPosition /*x, y*/,
-                     int /*x_offset*/,
-                     int /*y_offset*/,
-                     int /*device_id*/)
-
-IPC_MESSAGE_CONTROL3(WaylandInput_PointerEnter,  // NOLINT(readability/fn_size)
+IPC_MESSAGE_CONTROL4(WaylandInput_PointerEnter,  // NOLINT(readability/fn_size)
                      unsigned /*handle*/,
                      float /*x*/,
-                     float /*y*/)
+                     float /*y*/,
+                     uint32_t /*sequence*/)
 
-IPC_MESSAGE_CONTROL3(WaylandInput_PointerLeave,  // NOLINT(readability/fn_size)
+IPC_MESSAGE_CONTROL4(WaylandInput_PointerLeave,  // NOLINT(readability/fn_size)
                      unsigned /*handle*/,
                      float /*x*/,
-                     float /*y*/)
+                     float /*y*/,
+                     uint32_t /*sequence*/)
 
 IPC_MESSAGE_CONTROL2(WaylandInput_OutputSize,  // NOLINT(readability/fn_size)
                      unsigned /*width*/,
@@ -155,11 +160,18 @@ IPC_MESSAGE_CONTROL2(WaylandInput_SeatAssignmentChanged,  // NOLINT(readability/
                      std::string /* seat_name */,
                      unsigned /* window handle */)
 
-IPC_MESSAGE_CONTROL1(WaylandInput_KeyboardEnter,  // NOLINT(readability/fn_size)
-                     unsigned /*handle*/)
+IPC_MESSAGE_CONTROL2(WaylandInput_KeyboardEnter,  // NOLINT(readability/fn_size)
+                     unsigned /*handle*/,
+                     uint32_t /*sequence*/)
 
-IPC_MESSAGE_CONTROL1(WaylandInput_KeyboardLeave,  // NOLINT(readability/fn_size)
-                     unsigned /*handle*/)
+IPC_MESSAGE_CONTROL2(WaylandInput_KeyboardLeave,  // NOLINT(readability/fn_size)
+                     unsigned /*handle*/,
+                     uint32_t /*sequence*/)
+
+// The cursor types (ui::CursorType) the cursor theme of the GPU process has a
+// cursor for, see WaylandDisplay_CursorSetType.
+IPC_MESSAGE_CONTROL1(WaylandInput_CursorTheme,  // NOLINT(readability/fn_size)
+                     std::vector<int> /* cursor types */)
 
 //------------------------------------------------------------------------------
 // GPU Messages
@@ -186,23 +198,31 @@ IPC_MESSAGE_CONTROL2(WaylandDisplay_Title,  // NOLINT(readability/fn_size)
                      unsigned /* window handle */,
                      base::string16 /* window title */)
 
-IPC_MESSAGE_CONTROL5(WaylandDisplay_AddRegion,  // NOLINT(readability/fn_size)
+// Sets the opaque and input region of the window to the union of the
+// rectangles. An empty list resets both regions.
+IPC_MESSAGE_CONTROL2(WaylandDisplay_SetRegion,  // NOLINT(readability/fn_size)
                      unsigned /* window handle */,
-                     int /* left */,
-                     int /* top */,
-                     int /* right */,
-                     int /* bottom */)
+                     std::vector<gfx::Rect> /* rects */)
+
+// Shows the cursor |bitmaps| with their hotspot, animated cursors cycle
+// through the bitmaps every frame delay. The GPU process keeps the last
+// kMaxCachedCursors cursors by their id, and the browser, which tracks them in
+// the same least recently used order, sends WaylandDisplay_CursorShow instead
+// for those. An empty list hides the cursor.
+IPC_MESSAGE_CONTROL4(WaylandDisplay_CursorSet,  // NOLINT(readability/fn_size)
+                     std::vector<SkBitmap>,
+                     gfx::Point,
+                     int /* frame_delay_ms */,
+                     uint64_t /* cursor id */)
 
-IPC_MESSAGE_CONTROL5(WaylandDisplay_SubRegion,  // NOLINT(readability/fn_size)
-                     unsigned /* window handle */,
-                     int /* left */,
-                     int /* top */,
-                     int /* right */,
-                     int /* bottom */)
+// Shows the cached cursor |id|.
+IPC_MESSAGE_CONTROL1(WaylandDisplay_CursorShow,  // NOLINT(readability/fn_size)
+                     uint64_t /* cursor id */)
 
-IPC_MESSAGE_CONTROL2(WaylandDisplay_CursorSet,  // NOLINT(readability/fn_size)
-                     std::vector<SkBitmap>,
-                     gfx::Point)
+// Shows the cursor of the theme for |type|, one of those listed by
+// WaylandInput_CursorTheme. Theme cursors don't go through the cursor cache.
+IPC_MESSAGE_CONTROL1(WaylandDisplay_CursorSetType,  // NOLINT(readability/
+                     int /* cursor type */)         //        fn_size)
 
 IPC_MESSAGE_CONTROL1(WaylandDisplay_MoveCursor,  // NOLINT(readability/fn_size)
                      gfx::Point)
@@ -228,3 +248,41 @@ IPC_MESSAGE_CONTROL2(WaylandDisplay_DragWillBeAccepted,  // NOLINT(readability/
 
 IPC_MESSAGE_CONTROL1(WaylandDisplay_DragWillBeRejected,  // NOLINT(readability/
                      uint32_t /* serial */)              //        fn_size)
+
+// Sets up the shared memory ring used instead of WaylandInput_EventBatch for
+// pointer and touch events. |eventfd| is written every time records are added.
+IPC_MESSAGE_CONTROL3(WaylandDisplay_InputRing,  // NOLINT(readability/fn_size)
+                     base::SharedMemoryHandle /* ring */,
+                     uint32_t /* size */,
+                     base::FileDescriptor /* eventfd */)
+
+// Asks the browser to render the window at |scale| of its size, see
+// WaylandWindow::SetRenderScalePolicy.
+IPC_MESSAGE_CONTROL2(WaylandWindow_RenderScale,  // NOLINT(readability/fn_size)
+                     unsigned /* window handle */,
+                     float /* scale */)
+
+// The window is now rendered at |scale| of |logical_size|.
+IPC_MESSAGE_CONTROL3(WaylandDisplay_RenderScale,  // NOLINT(readability/fn_size)
+                     unsigned /* window handle */,
+                     float /* scale */,
+                     gfx::Size /* logical_size */)
+
+// Memory the browser renders the |size| frames of a window composited in
+// software into, as N32 premultiplied rows of size.width() pixels. Sent
+// whenever the canvas is allocated, see SurfaceOzoneCanvasHost.
+IPC_MESSAGE_CONTROL3(WaylandDisplay_CanvasMemory,  // NOLINT(readability/
+                     unsigned /* window handle */,  //        fn_size)
+                     gfx::Size /* size */,
+                     base::SharedMemoryHandle /* pixels */)
+
+// Presents the |damage| part of the frame last rendered into the canvas
+// memory of the window.
+IPC_MESSAGE_CONTROL2(WaylandDisplay_PresentCanvas,  // NOLINT(readability/
+                     unsigned /* window handle */,  //        fn_size)
+                     gfx::Rect /* damage */)
+
+// Releases the canvas memory and buffers of the window. The window itself
+// stays until it is DESTROYED, a new canvas may be created for it.
+IPC_MESSAGE_CONTROL1(WaylandDisplay_DestroyCanvas,  // NOLINT(readability/
+                     unsigned /* window handle */)  //        fn_size)
@@ -0,0 +1,103 @@
+// Copyright 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/overlay_manager_wayland.h"
+
+#include "ui/gfx/geometry/rect_conversions.h"
+#include "ui/ozone/public/overlay_candidates_ozone.h"
+
+namespace ui {
+
+namespace {
+
+// Compositors rarely have more hardware planes to offer a single client.
+const int kMaxOverlays = 3;
+
+#if defined(ENABLE_DRM_SUPPORT)
+// The formats WaylandPixmap can allocate.
+bool IsSupportedFormat(gfx::BufferFormat format) {
+  switch (format) {
+    case gfx::BufferFormat::RGBA_8888:
+    case gfx::BufferFormat::RGBX_8888:
+      return true;
+    default:
+      return false;
+  }
+}
+#endif
+
+class OverlayCandidatesWayland : public OverlayCandidatesOzone {
+ public:
+  OverlayCandidatesWayland() {}
+  ~OverlayCandidatesWayland() override {}
+
+  // OverlayCandidatesOzone:
+  void CheckOverlaySupport(OverlaySurfaceCandidateList* candidates) override;
+
+ private:
+  bool CanPromote(const OverlaySurfaceCandidate& candidate) const;
+
+  DISALLOW_COPY_AND_ASSIGN(OverlayCandidatesWayland);
+};
+
+void OverlayCandidatesWayland::CheckOverlaySupport(
+    OverlaySurfaceCandidateList* candidates) {
+  int overlays = 0;
+  for (OverlaySurfaceCandidate& candidate : *candidates) {
+    // z order 0 is the window surface itself.
+    if (candidate.plane_z_order == 0)
+      continue;
+
+    candidate.overlay_handled = overlays < kMaxOverlays &&
+                                CanPromote(candidate);
+    if (candidate.overlay_handled)
+      overlays++;
+  }
+}
+
+bool OverlayCandidatesWayland::CanPromote(
+    const OverlaySurfaceCandidate& candidate) const {
+#if defined(ENABLE_DRM_SUPPORT)
+  if (candidate.transform != gfx::OVERLAY_TRANSFORM_NONE)
+    return false;
+
+  if (!IsSupportedFormat(candidate.format))
+    return false;
+
+  // Subsurfaces are placed at integer positions and show the whole buffer.
+  gfx::Rect display_rect = gfx::ToNearestRect(candidate.display_rect);
+  if (gfx::RectF(display_rect) != candidate.display_rect)
+    return false;
+
+  if (display_rect.size() != candidate.buffer_size)
+    return false;
+
+  if (candidate.crop_rect != gfx::RectF(0, 0, 1, 1))
+    return false;
+
+  if (candidate.is_clipped && !candidate.clip_rect.Contains(display_rect))
+    return false;
+
+  return true;
+#else
+  // Buffers can only be shared with the compositor through wl_drm.
+  return false;
+#endif
+}
+
+}  // namespace
+
+OverlayManagerWayland::OverlayManagerWayland() {
+}
+
+OverlayManagerWayland::~OverlayManagerWayland() {
+}
+
+std::unique_ptr<OverlayCandidatesOzone>
+OverlayManagerWayland::CreateOverlayCandidates(gfx::AcceleratedWidget widget) {
+  return std::unique_ptr<OverlayCandidatesOzone>(
+      new OverlayCandidatesWayland());
+}
+
+}  // namespace ui
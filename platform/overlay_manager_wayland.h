@@ -0,0 +1,34 @@
+// Copyright 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_IMPL_PLATFORM_OVERLAY_MANAGER_WAYLAND_H_
+#define OZONE_IMPL_PLATFORM_OVERLAY_MANAGER_WAYLAND_H_
+
+#include <memory>
+
+#include "base/macros.h"
+#include "ui/ozone/public/overlay_manager_ozone.h"
+
+namespace ui {
+
+// Promotes overlay candidates that the compositor can show as they are, that
+// is without any transform, scaling or cropping, to wl_subsurfaces of the
+// window. On the GPU side they are stacked by WaylandWindow::ScheduleOverlay
+// according to their plane z order.
+class OverlayManagerWayland : public OverlayManagerOzone {
+ public:
+  OverlayManagerWayland();
+  ~OverlayManagerWayland() override;
+
+  // OverlayManagerOzone:
+  std::unique_ptr<OverlayCandidatesOzone> CreateOverlayCandidates(
+      gfx::AcceleratedWidget widget) override;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(OverlayManagerWayland);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_IMPL_PLATFORM_OVERLAY_MANAGER_WAYLAND_H_
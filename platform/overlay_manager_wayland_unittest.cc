@@ -0,0 +1,121 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/overlay_manager_wayland.h"
+
+#include <memory>
+
+#include "testing/gtest/include/gtest/gtest.h"
+#include "ui/ozone/public/overlay_candidates_ozone.h"
+
+namespace ui {
+
+namespace {
+
+typedef OverlayCandidatesOzone::OverlaySurfaceCandidate Candidate;
+typedef OverlayCandidatesOzone::OverlaySurfaceCandidateList CandidateList;
+
+// A candidate the compositor can show as it is.
+Candidate CreateCandidate(int z_order) {
+  Candidate candidate;
+  candidate.plane_z_order = z_order;
+  candidate.transform = gfx::OVERLAY_TRANSFORM_NONE;
+  candidate.format = gfx::BufferFormat::RGBA_8888;
+  candidate.buffer_size = gfx::Size(64, 32);
+  candidate.display_rect = gfx::RectF(10, 20, 64, 32);
+  candidate.crop_rect = gfx::RectF(0, 0, 1, 1);
+  candidate.is_clipped = false;
+  candidate.overlay_handled = false;
+  return candidate;
+}
+
+bool IsPromoted(const Candidate& candidate) {
+  OverlayManagerWayland manager;
+  std::unique_ptr<OverlayCandidatesOzone> candidates =
+      manager.CreateOverlayCandidates(gfx::kNullAcceleratedWidget);
+  CandidateList list(1, candidate);
+  candidates->CheckOverlaySupport(&list);
+  return list[0].overlay_handled;
+}
+
+}  // namespace
+
+TEST(OverlayManagerWaylandTest, SkipsTheWindowSurface) {
+  EXPECT_FALSE(IsPromoted(CreateCandidate(0)));
+}
+
+#if defined(ENABLE_DRM_SUPPORT)
+
+TEST(OverlayManagerWaylandTest, PromotesUnscaledCandidates) {
+  EXPECT_TRUE(IsPromoted(CreateCandidate(1)));
+  EXPECT_TRUE(IsPromoted(CreateCandidate(-1)));
+
+  Candidate candidate = CreateCandidate(1);
+  candidate.format = gfx::BufferFormat::RGBX_8888;
+  EXPECT_TRUE(IsPromoted(candidate));
+}
+
+TEST(OverlayManagerWaylandTest, RejectsCandidatesNeedingComposition) {
+  Candidate transformed = CreateCandidate(1);
+  transformed.transform = gfx::OVERLAY_TRANSFORM_ROTATE_90;
+  EXPECT_FALSE(IsPromoted(transformed));
+
+  Candidate unsupported_format = CreateCandidate(1);
+  unsupported_format.format = gfx::BufferFormat::YUV_420_BIPLANAR;
+  EXPECT_FALSE(IsPromoted(unsupported_format));
+
+  Candidate scaled = CreateCandidate(1);
+  scaled.display_rect = gfx::RectF(10, 20, 128, 64);
+  EXPECT_FALSE(IsPromoted(scaled));
+
+  Candidate fractional = CreateCandidate(1);
+  fractional.display_rect = gfx::RectF(10.5f, 20, 64, 32);
+  EXPECT_FALSE(IsPromoted(fractional));
+
+  Candidate cropped = CreateCandidate(1);
+  cropped.crop_rect = gfx::RectF(0, 0, 0.5f, 1);
+  EXPECT_FALSE(IsPromoted(cropped));
+}
+
+TEST(OverlayManagerWaylandTest, RejectsClippedCandidates) {
+  Candidate inside_clip = CreateCandidate(1);
+  inside_clip.is_clipped = true;
+  inside_clip.clip_rect = gfx::Rect(0, 0, 100, 100);
+  EXPECT_TRUE(IsPromoted(inside_clip));
+
+  Candidate clipped = CreateCandidate(1);
+  clipped.is_clipped = true;
+  clipped.clip_rect = gfx::Rect(0, 0, 40, 40);
+  EXPECT_FALSE(IsPromoted(clipped));
+}
+
+TEST(OverlayManagerWaylandTest, LimitsTheNumberOfOverlays) {
+  OverlayManagerWayland manager;
+  std::unique_ptr<OverlayCandidatesOzone> candidates =
+      manager.CreateOverlayCandidates(gfx::kNullAcceleratedWidget);
+  CandidateList list;
+  list.push_back(CreateCandidate(-1));
+  list.push_back(CreateCandidate(0));
+  list.push_back(CreateCandidate(1));
+  list.push_back(CreateCandidate(2));
+  list.push_back(CreateCandidate(3));
+  candidates->CheckOverlaySupport(&list);
+
+  EXPECT_TRUE(list[0].overlay_handled);
+  EXPECT_FALSE(list[1].overlay_handled);
+  EXPECT_TRUE(list[2].overlay_handled);
+  EXPECT_TRUE(list[3].overlay_handled);
+  EXPECT_FALSE(list[4].overlay_handled);
+}
+
+#else
+
+TEST(OverlayManagerWaylandTest, RejectsCandidatesWithoutDrm) {
+  EXPECT_FALSE(IsPromoted(CreateCandidate(1)));
+  EXPECT_FALSE(IsPromoted(CreateCandidate(-1)));
+}
+
+#endif
+
+}  // namespace ui
@@ -9,17 +9,17 @@
 #include "base/at_exit.h"
 #include "base/bind.h"
 #include "base/memory/ptr_util.h"
+#include "ozone/platform/bitmap_cursor_factory_wayland.h"
+#include "ozone/platform/overlay_manager_wayland.h"
 #include "ozone/platform/ozone_gpu_platform_support_host.h"
 #include "ozone/platform/ozone_wayland_window.h"
 #include "ozone/platform/window_manager_wayland.h"
 #include "ozone/wayland/display.h"
 #include "ozone/wayland/ozone_wayland_screen.h"
-#include "ui/base/cursor/ozone/bitmap_cursor_factory_ozone.h"
 #include "ui/events/ozone/layout/keyboard_layout_engine_manager.h"
 #include "ui/events/ozone/layout/xkb/xkb_evdev_codes.h"
 #include "ui/events/ozone/layout/xkb/xkb_keyboard_layout_engine.h"
 #include "ui/ozone/common/native_display_delegate_ozone.h"
-#include "ui/ozone/common/stub_overlay_manager.h"
 #include "ui/ozone/public/system_input_injector.h"
 #include "ui/platform_window/platform_window_delegate.h"
 
@@ -102,8 +102,9 @@ class OzonePlatformWayland : public OzonePlatform {
     gpu_platform_host_.reset(new ui::OzoneGpuPlatformSupportHost());
     // Needed as Browser creates accelerated widgets through SFO.
     wayland_display_.reset(new ozonewayland::WaylandDisplay());
-    cursor_factory_ozone_.reset(new ui::BitmapCursorFactoryOzone());
-    overlay_manager_.reset(new StubOverlayManager());
+    wayland_display_->SetCanvasSender(gpu_platform_host_.get());
+    cursor_factory_ozone_.reset(new ui::BitmapCursorFactoryWayland());
+    overlay_manager_.reset(new OverlayManagerWayland());
     KeyboardLayoutEngineManager::SetKeyboardLayoutEngine(base::WrapUnique(
         new XkbKeyboardLayoutEngine(xkb_evdev_code_converter_)));
     window_manager_.reset(
@@ -119,9 +120,9 @@ class OzonePlatformWayland : public OzonePlatform {
   }
 
  private:
-  std::unique_ptr<ui::BitmapCursorFactoryOzone> cursor_factory_ozone_;
+  std::unique_ptr<ui::BitmapCursorFactoryWayland> cursor_factory_ozone_;
   std::unique_ptr<ozonewayland::WaylandDisplay> wayland_display_;
-  std::unique_ptr<StubOverlayManager> overlay_manager_;
+  std::unique_ptr<OverlayManagerWayland> overlay_manager_;
   std::unique_ptr<ui::WindowManagerWayland> window_manager_;
   XkbEvdevCodes xkb_evdev_code_converter_;
   std::unique_ptr<ui::OzoneGpuPlatformSupportHost> gpu_platform_host_;
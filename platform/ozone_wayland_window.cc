@@ -6,6 +6,7 @@
 
 #include <vector>
 #include "base/bind.h"
+#include "ozone/platform/bitmap_cursor_factory_wayland.h"
 #include "ozone/platform/messages.h"
 #include "ozone/platform/ozone_gpu_platform_support_host.h"
 #include "ozone/platform/ozone_wayland_seat.h"
@@ -15,10 +16,51 @@
 #include "ui/events/platform/platform_event_source.h"
 #include "ui/display/display.h"
 #include "ui/display/screen.h"
+#include "ui/ozone/public/cursor_factory_ozone.h"
 #include "ui/platform_window/platform_window_delegate.h"
 
 namespace ui {
 
+namespace {
+
+// FNV-1a, the cursor ids only need to tell apart the few dozen cursors
+// used at a time.
+const uint64_t kFnvOffsetBasis = 14695981039346656037ULL;
+const uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; ++i)
+    hash = (hash ^ bytes[i]) * kFnvPrime;
+
+  return hash;
+}
+
+// Identifies a cursor by its content, so that equal cursors created from
+// different BitmapCursorOzone objects share the same entry of the cache.
+uint64_t GetCursorId(const BitmapCursorOzone& cursor) {
+  uint64_t hash = kFnvOffsetBasis;
+  gfx::Point hotspot = cursor.hotspot();
+  int header[] = { hotspot.x(), hotspot.y(), cursor.frame_delay_ms() };
+  hash = HashBytes(hash, header, sizeof(header));
+  for (const SkBitmap& bitmap : cursor.bitmaps()) {
+    SkAutoLockPixels lock(bitmap);
+    int size[] = { bitmap.width(), bitmap.height() };
+    hash = HashBytes(hash, size, sizeof(size));
+    if (!bitmap.getPixels())
+      continue;
+
+    const uint8_t* row = static_cast<const uint8_t*>(bitmap.getPixels());
+    for (int y = 0; y < bitmap.height(); ++y, row += bitmap.rowBytes())
+      hash = HashBytes(hash, row, bitmap.width() * bitmap.bytesPerPixel());
+  }
+
+  // 0 stands for no cursor.
+  return hash ? hash : 1;
+}
+
+}  // namespace
+
 OzoneWaylandWindow::OzoneWaylandWindow(PlatformWindowDelegate* delegate,
                                        OzoneGpuPlatformSupportHost* sender,
                                        WindowManagerWayland* window_manager,
@@ -33,7 +75,8 @@ OzoneWaylandWindow::OzoneWaylandWindow(PlatformWindowDelegate* delegate,
       region_(NULL),
       cursor_type_(-1),
       keyboard_focus_(false),
-      pointer_focus_(false) {
+      pointer_focus_(false),
+      render_scale_(1.0f) {
   static int opaque_handle = 0;
   opaque_handle++;
   handle_ = opaque_handle;
@@ -41,6 +84,9 @@ OzoneWaylandWindow::OzoneWaylandWindow(PlatformWindowDelegate* delegate,
 }
 
 OzoneWaylandWindow::~OzoneWaylandWindow() {
+  // Lets the GPU process release the window of a software canvas.
+  state_ = ui::DESTROYED;
+  SendWidgetState();
   sender_->RemoveGpuThreadObserver(this);
   PlatformEventSource::GetInstance()->RemovePlatformEventDispatcher(this);
   if (region_)
@@ -150,9 +196,25 @@ void OzoneWaylandWindow::SetBounds(const gfx::Rect& bounds) {
                                                 type_, bounds_));
   }
 
+  if (render_scale_ != 1.0f) {
+    sender_->Send(new WaylandDisplay_RenderScale(handle_, render_scale_,
+                                                 bounds_.size()));
+  }
+
   delegate_->OnBoundsChanged(bounds_);
 }
 
+void OzoneWaylandWindow::SetRenderScale(float scale) {
+  if (render_scale_ == scale)
+    return;
+
+  render_scale_ = scale;
+  sender_->Send(new WaylandDisplay_RenderScale(handle_, render_scale_,
+                                               bounds_.size()));
+  if (!render_scale_callback_.is_null())
+    render_scale_callback_.Run(render_scale_);
+}
+
 void OzoneWaylandWindow::Show() {
   state_ = ui::SHOW;
   SendWidgetState();
@@ -214,6 +276,8 @@ void OzoneWaylandWindow::SetCursor(PlatformCursor cursor) {
   scoped_refptr<BitmapCursorOzone> bitmap =
       BitmapCursorFactoryOzone::GetBitmapCursor(cursor);
   bitmap_ = bitmap;
+  cursor_type_ = static_cast<BitmapCursorFactoryWayland*>(
+      CursorFactoryOzone::GetInstance())->GetCursorType(cursor);
   window_manager_->SetPlatformCursor(cursor);
   if (!sender_->IsConnected())
     return;
@@ -276,24 +340,22 @@ void OzoneWaylandWindow::SendWidgetState() {
 
 void OzoneWaylandWindow::AddRegion() {
   if (sender_->IsConnected() && region_ && !region_->isEmpty()) {
-     const SkIRect& rect = region_->getBounds();
-     sender_->Send(new WaylandDisplay_AddRegion(handle_,
-                                                rect.left(),
-                                                rect.top(),
-                                                rect.right(),
-                                                rect.bottom()));
+    std::vector<gfx::Rect> rects;
+    for (SkRegion::Iterator it(*region_); !it.done(); it.next()) {
+      const SkIRect& rect = it.rect();
+      rects.push_back(
+          gfx::Rect(rect.left(), rect.top(), rect.width(), rect.height()));
+    }
+
+    sender_->Send(new WaylandDisplay_SetRegion(handle_, rects));
   }
 }
 
 void OzoneWaylandWindow::ResetRegion() {
   if (region_) {
     if (sender_->IsConnected() && !region_->isEmpty()) {
-      const SkIRect& rect = region_->getBounds();
-      sender_->Send(new WaylandDisplay_SubRegion(handle_,
-                                                 rect.left(),
-                                                 rect.top(),
-                                                 rect.right(),
-                                                 rect.bottom()));
+      sender_->Send(new WaylandDisplay_SetRegion(handle_,
+                                                 std::vector<gfx::Rect>()));
     }
 
     delete region_;
@@ -302,13 +364,31 @@ void OzoneWaylandWindow::ResetRegion() {
 }
 
 void OzoneWaylandWindow::SetCursor() {
-  if (bitmap_) {
-    sender_->Send(new WaylandDisplay_CursorSet(bitmap_->bitmaps(),
-                                               bitmap_->hotspot()));
-  } else {
+  // Theme cursors are already in the compositor's memory, no need to upload
+  // anything.
+  if (window_manager_->IsThemedCursor(cursor_type_)) {
+    sender_->Send(new WaylandDisplay_CursorSetType(cursor_type_));
+    return;
+  }
+
+  if (!bitmap_ || bitmap_->bitmaps().empty()) {
     sender_->Send(new WaylandDisplay_CursorSet(std::vector<SkBitmap>(),
-                                               gfx::Point()));
+                                               gfx::Point(),
+                                               0,
+                                               0));
+    return;
   }
+
+  uint64_t id = GetCursorId(*bitmap_);
+  if (window_manager_->UseCursor(id)) {
+    sender_->Send(new WaylandDisplay_CursorShow(id));
+    return;
+  }
+
+  sender_->Send(new WaylandDisplay_CursorSet(bitmap_->bitmaps(),
+                                             bitmap_->hotspot(),
+                                             bitmap_->frame_delay_ms(),
+                                             id));
 }
 
 void OzoneWaylandWindow::ValidateBounds() {
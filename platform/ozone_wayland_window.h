@@ -6,6 +6,7 @@
 #define OZONE_PLATFORM_OZONE_WAYLAND_WINDOW_H_
 
 #include <string>
+#include "base/callback.h"
 #include "base/memory/ref_counted.h"
 #include "ozone/platform/window_constants.h"
 #include "third_party/skia/include/core/SkRegion.h"
@@ -75,6 +76,16 @@ class OzoneWaylandWindow : public PlatformWindow,
   void SetKeyboardFocus(bool focus) { keyboard_focus_ = focus; }
   void SetPointerFocus(bool focus) { pointer_focus_ = focus; }
 
+  // The GPU process asks for the window to be rendered at |scale| of its
+  // size when it can't keep up with the display, the compositor of the
+  // window is expected to follow through |callback|.
+  typedef base::Callback<void(float)> RenderScaleCallback;
+  void SetRenderScaleCallback(const RenderScaleCallback& callback) {
+    render_scale_callback_ = callback;
+  }
+  void SetRenderScale(float scale);
+  float render_scale() const { return render_scale_; }
+
  private:
   void SendWidgetState();
   void AddRegion();
@@ -92,12 +103,16 @@ class OzoneWaylandWindow : public PlatformWindow,
   ui::WidgetType type_;
   ui::WidgetState state_;
   SkRegion* region_;
+  // The ui::CursorType of the current cursor, kCursorCustom if it isn't a
+  // default one.
   int cursor_type_;
   base::string16 title_;
   // The current cursor bitmap (immutable).
   scoped_refptr<BitmapCursorOzone> bitmap_;
   bool keyboard_focus_;
   bool pointer_focus_;
+  float render_scale_;
+  RenderScaleCallback render_scale_callback_;
 
   DISALLOW_COPY_AND_ASSIGN(OzoneWaylandWindow);
 };
@@ -0,0 +1,89 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/platform/surface_ozone_canvas_host.h"
+
+#include "base/logging.h"
+#include "base/memory/shared_memory.h"
+#include "base/trace_event/trace_event.h"
+#include "ipc/ipc_sender.h"
+#include "ozone/platform/messages.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/vsync_provider.h"
+
+namespace ui {
+
+namespace {
+
+// Frees the canvas memory along with the last reference to its surface.
+void ReleasePixels(void* pixels, void* context) {
+  delete static_cast<base::SharedMemory*>(context);
+}
+
+}  // namespace
+
+SurfaceOzoneCanvasHost::SurfaceOzoneCanvasHost(unsigned handle,
+                                               IPC::Sender* sender)
+    : handle_(handle),
+      sender_(sender) {
+}
+
+SurfaceOzoneCanvasHost::~SurfaceOzoneCanvasHost() {
+  sender_->Send(new WaylandDisplay_DestroyCanvas(handle_));
+}
+
+sk_sp<SkSurface> SurfaceOzoneCanvasHost::GetSurface() {
+  return surface_;
+}
+
+void SurfaceOzoneCanvasHost::ResizeCanvas(const gfx::Size& viewport_size) {
+  if (size_ == viewport_size)
+    return;
+
+  size_ = viewport_size;
+  surface_ = nullptr;
+  if (size_.IsEmpty())
+    return;
+
+  SkImageInfo info = SkImageInfo::MakeN32Premul(size_.width(),
+                                                size_.height());
+  size_t stride = info.minRowBytes();
+  std::unique_ptr<base::SharedMemory> pixels(new base::SharedMemory());
+  if (!pixels->CreateAndMapAnonymous(stride * size_.height())) {
+    LOG(ERROR) << "Failed to allocate the canvas.";
+    return;
+  }
+
+  sender_->Send(new WaylandDisplay_CanvasMemory(
+      handle_,
+      size_,
+      base::SharedMemory::DuplicateHandle(pixels->handle())));
+  // The previous surface may still be referenced, each one owns its memory.
+  void* memory = pixels->memory();
+  surface_ = SkSurface::MakeRasterDirectReleaseProc(info, memory, stride,
+                                                    ReleasePixels,
+                                                    pixels.release());
+}
+
+void SurfaceOzoneCanvasHost::PresentCanvas(const gfx::Rect& damage) {
+  gfx::Rect damaged_rect = gfx::IntersectRects(damage, gfx::Rect(size_));
+  if (!surface_ || damaged_rect.IsEmpty())
+    return;
+
+  TRACE_EVENT2("ozone", "SurfaceOzoneCanvasHost::PresentCanvas",
+               "width", damaged_rect.width(),
+               "height", damaged_rect.height());
+  // The GPU process copies the rect out of the canvas memory when it gets
+  // the message. The browser may be painting the next frame by then, which
+  // only shows part of that frame early, it is presented right after.
+  sender_->Send(new WaylandDisplay_PresentCanvas(handle_, damaged_rect));
+}
+
+std::unique_ptr<gfx::VSyncProvider>
+SurfaceOzoneCanvasHost::CreateVSyncProvider() {
+  // The frame callbacks are received in the GPU process.
+  return nullptr;
+}
+
+}  // namespace ui
@@ -0,0 +1,47 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_PLATFORM_SURFACE_OZONE_CANVAS_HOST_H_
+#define OZONE_PLATFORM_SURFACE_OZONE_CANVAS_HOST_H_
+
+#include <memory>
+
+#include "base/macros.h"
+#include "third_party/skia/include/core/SkSurface.h"
+#include "ui/gfx/geometry/size.h"
+#include "ui/ozone/public/surface_ozone_canvas.h"
+
+namespace IPC {
+class Sender;
+}
+
+namespace ui {
+
+// Software compositing runs in the browser process, while the windows and
+// the Wayland connection live in the GPU process. The canvas is rendered into
+// memory shared with the GPU process, allocated once per canvas size (see
+// WaylandDisplay_CanvasMemory). Each frame only sends the damaged rect, which
+// the GPU process copies into a wl_shm backed canvas of its own.
+class SurfaceOzoneCanvasHost : public SurfaceOzoneCanvas {
+ public:
+  SurfaceOzoneCanvasHost(unsigned handle, IPC::Sender* sender);
+  ~SurfaceOzoneCanvasHost() override;
+
+  // SurfaceOzoneCanvas:
+  sk_sp<SkSurface> GetSurface() override;
+  void ResizeCanvas(const gfx::Size& viewport_size) override;
+  void PresentCanvas(const gfx::Rect& damage) override;
+  std::unique_ptr<gfx::VSyncProvider> CreateVSyncProvider() override;
+
+ private:
+  unsigned handle_;
+  IPC::Sender* sender_;
+  gfx::Size size_;
+  sk_sp<SkSurface> surface_;
+  DISALLOW_COPY_AND_ASSIGN(SurfaceOzoneCanvasHost);
+};
+
+}  // namespace ui
+
+#endif  // OZONE_PLATFORM_SURFACE_OZONE_CANVAS_HOST_H_
@@ -5,6 +5,9 @@
 #ifndef OZONE_UI_EVENTS_WINDOW_CONSTANTS_H_
 #define OZONE_UI_EVENTS_WINDOW_CONSTANTS_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 namespace ui {
 
   enum WidgetState {
@@ -40,6 +43,37 @@ struct PointerPosition {
   float y;
 };
 
+  enum InputEventKind {
+    INPUT_MOTION = 0,  // Pointer motion.
+    INPUT_BUTTON = 1,  // Pointer button press or release.
+    INPUT_AXIS = 2,  // Pointer axis (scroll).
+    INPUT_TOUCH = 3,  // Touch down, up, motion or cancel.
+    INPUT_MOTION_HISTORY = 4  // Raw motion sample merged into the next
+      // INPUT_MOTION record of the batch.
+  };
+
+// A single pointer or touch event, as packed into WaylandInput_EventBatch.
+// Fields which don't apply to |kind| are left at zero.
+struct InputEventRecord {
+  InputEventRecord()
+  : kind(INPUT_MOTION), handle(0), type(0), flags(0), x_offset(0),
+    y_offset(0), touch_id(0), time_stamp(0), device_id(0) {}
+
+  InputEventKind kind;
+  unsigned handle;
+  int type;  // ui::EventType
+  int flags;  // ui::EventFlags
+  PointerPosition position;
+  int x_offset;
+  int y_offset;
+  int32_t touch_id;
+  uint32_t time_stamp;
+  int device_id;
+};
+
+// Number of cursors the GPU process keeps ready, see WaylandDisplay_CursorSet.
+const size_t kMaxCachedCursors = 16;
+
 }  // namespace ui
 
 #endif  // OZONE_UI_EVENTS_WINDOW_CONSTANTS_H_
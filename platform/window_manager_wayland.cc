@@ -4,10 +4,16 @@
 
 #include "ozone/platform/window_manager_wayland.h"
 
+#include <stdlib.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
 #include <string>
 
 #include "base/bind.h"
+#include "base/message_loop/message_loop.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "ozone/platform/desktop_platform_screen_delegate.h"
 #include "ozone/platform/messages.h"
@@ -33,11 +39,14 @@ WindowManagerWayland::WindowManagerWayland(OzoneGpuPlatformSupportHost* proxy)
                 base::Bind(&WindowManagerWayland::PostUiEvent,
                            base::Unretained(this))),
       platform_screen_(NULL),
+      input_ring_fd_(-1),
+      input_sequence_(0),
       weak_ptr_factory_(this) {
   proxy_->RegisterHandler(this);
 }
 
 WindowManagerWayland::~WindowManagerWayland() {
+  ResetInputRing();
   if (!seats_.empty()) {
     STLDeleteValues(&seats_);
     seats_.clear();
@@ -91,6 +100,25 @@ void WindowManagerWayland::SetPlatformCursor(PlatformCursor cursor) {
   platform_cursor_ = cursor;
 }
 
+bool WindowManagerWayland::UseCursor(uint64_t id) {
+  std::list<uint64_t>::iterator it =
+      std::find(cached_cursors_.begin(), cached_cursors_.end(), id);
+  if (it != cached_cursors_.end()) {
+    cached_cursors_.splice(cached_cursors_.begin(), cached_cursors_, it);
+    return true;
+  }
+
+  cached_cursors_.push_front(id);
+  if (cached_cursors_.size() > kMaxCachedCursors)
+    cached_cursors_.pop_back();
+
+  return false;
+}
+
+bool WindowManagerWayland::IsThemedCursor(int type) const {
+  return themed_cursor_types_.count(type) > 0;
+}
+
 bool WindowManagerWayland::HasWindowsOpen() const {
   return open_windows_ ? !open_windows_->empty() : false;
 }
@@ -215,6 +243,17 @@ void WindowManagerWayland::OnWindowUnminimized(unsigned handle) {
   window->GetDelegate()->OnWindowStateChanged(PLATFORM_WINDOW_STATE_MAXIMIZED);
 }
 
+void WindowManagerWayland::OnWindowRenderScale(unsigned handle, float scale) {
+  OzoneWaylandWindow* window = GetWindow(handle);
+  if (!window) {
+    LOG(ERROR) << "Received invalid window handle " << handle
+               << " from GPU process";
+    return;
+  }
+
+  window->SetRenderScale(scale);
+}
+
 void WindowManagerWayland::OnWindowDeActivated(unsigned windowhandle) {
   OnActivationChanged(windowhandle, false);
 }
@@ -228,12 +267,27 @@ void WindowManagerWayland::OnWindowActivated(unsigned windowhandle) {
 void WindowManagerWayland::OnChannelEstablished(
   int host_id, scoped_refptr<base::SingleThreadTaskRunner> send_runner,
       const base::Callback<void(IPC::Message*)>& send_callback) {
+  input_sequence_ = 0;
+  input_sequences_ahead_.clear();
+  // A new GPU process starts with an empty cursor cache.
+  cached_cursors_.clear();
+  themed_cursor_types_.clear();
+  ResetInputRing();
+  if (getenv("OZONE_WAYLAND_INPUT_RING"))
+    SetupInputRing();
 }
 
 void WindowManagerWayland::OnChannelDestroyed(int host_id) {
+  ResetInputRing();
 }
 
 bool WindowManagerWayland::OnMessageReceived(const IPC::Message& message) {
+  if (IPC_MESSAGE_CLASS(message) != LastIPCMsgStart)
+    return false;
+
+  // Records written to the ring before this message was sent go first.
+  DrainInputRing();
+
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(WindowManagerWayland, message)
   IPC_MESSAGE_HANDLER(WaylandInput_CloseWidget, CloseWidget)
@@ -241,10 +295,8 @@ bool WindowManagerWayland::OnMessageReceived(const IPC::Message& message) {
   IPC_MESSAGE_HANDLER(WaylandWindow_Activated, WindowActivated)
   IPC_MESSAGE_HANDLER(WaylandWindow_DeActivated, WindowDeActivated)
   IPC_MESSAGE_HANDLER(WaylandWindow_Unminimized, WindowUnminimized)
-  IPC_MESSAGE_HANDLER(WaylandInput_MotionNotify, MotionNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_ButtonNotify, ButtonNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_TouchNotify, TouchNotify)
-  IPC_MESSAGE_HANDLER(WaylandInput_AxisNotify, AxisNotify)
+  IPC_MESSAGE_HANDLER(WaylandWindow_RenderScale, WindowRenderScale)
+  IPC_MESSAGE_HANDLER(WaylandInput_EventBatch, EventBatch)
   IPC_MESSAGE_HANDLER(WaylandInput_PointerEnter, PointerEnter)
   IPC_MESSAGE_HANDLER(WaylandInput_PointerLeave, PointerLeave)
   IPC_MESSAGE_HANDLER(WaylandInput_KeyNotify, KeyNotify)
@@ -260,43 +312,128 @@ bool WindowManagerWayland::OnMessageReceived(const IPC::Message& message) {
   IPC_MESSAGE_HANDLER(WaylandInput_SeatAssignmentChanged, SeatAssignmentChanged)
   IPC_MESSAGE_HANDLER(WaylandInput_KeyboardEnter, KeyboardEnter)
   IPC_MESSAGE_HANDLER(WaylandInput_KeyboardLeave, KeyboardLeave)
+  IPC_MESSAGE_HANDLER(WaylandInput_CursorTheme, CursorTheme)
   IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
+  DrainInputRing();
   return handled;
 }
 
-void WindowManagerWayland::MotionNotify(ui::PointerPosition position, int device_id) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyMotion,
-          weak_ptr_factory_.GetWeakPtr(), position.x, position.y, device_id));
+void WindowManagerWayland::OnFileCanReadWithoutBlocking(int fd) {
+  uint64_t value;
+  HANDLE_EINTR(read(fd, &value, sizeof(value)));
+  DrainInputRing();
 }
 
-void WindowManagerWayland::ButtonNotify(unsigned handle,
-                                        EventType type,
-                                        EventFlags flags,
-                                        ui::PointerPosition position,
-                                        int device_id) {
+void WindowManagerWayland::OnFileCanWriteWithoutBlocking(int fd) {
+  NOTREACHED();
+}
+
+void WindowManagerWayland::SetupInputRing() {
+  const uint32_t kInputRingCapacity = 1024;
+  size_t size = InputEventRing::RequiredSize(kInputRingCapacity);
+  std::unique_ptr<base::SharedMemory> memory(new base::SharedMemory());
+  if (!memory->CreateAndMapAnonymous(size)) {
+    LOG(ERROR) << "Failed to allocate the input event ring.";
+    return;
+  }
+
+  // The GPU process keeps sending the events as messages without a ring.
+  if (!input_ring_.Attach(memory->memory(), size, true)) {
+    LOG(ERROR) << "Failed to set up the input event ring.";
+    return;
+  }
+
+  int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (fd < 0) {
+    LOG(ERROR) << "Failed to create the input event ring eventfd.";
+    input_ring_.Detach();
+    return;
+  }
+
+  input_ring_memory_ = std::move(memory);
+  input_ring_fd_ = fd;
+  base::MessageLoopForUI::current()->WatchFileDescriptor(
+      input_ring_fd_, true, base::MessagePumpLibevent::WATCH_READ,
+      &input_ring_watcher_, this);
+
+  proxy_->Send(new WaylandDisplay_InputRing(
+      base::SharedMemory::DuplicateHandle(input_ring_memory_->handle()),
+      size,
+      base::FileDescriptor(dup(input_ring_fd_), true)));
+}
+
+void WindowManagerWayland::ResetInputRing() {
+  input_ring_watcher_.StopWatchingFileDescriptor();
+  input_ring_.Detach();
+  input_ring_memory_.reset();
+  if (input_ring_fd_ >= 0) {
+    close(input_ring_fd_);
+    input_ring_fd_ = -1;
+  }
+}
+
+void WindowManagerWayland::DrainInputRing() {
+  if (!input_ring_.IsAttached())
+    return;
+
+  // A batch can be handled once the input message or batch right before it
+  // has been.
+  std::vector<InputEventRecord> events;
+  InputEventRecord event;
+  uint32_t sequence;
+  while (input_ring_.Pop(input_sequence_ + 1, &event, &sequence)) {
+    events.push_back(event);
+    UpdateInputSequence(sequence);
+  }
+
+  if (input_ring_.IsCorrupted())
+    ResetInputRing();
+
+  if (events.empty())
+    return;
+
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyButtonPress,
-          weak_ptr_factory_.GetWeakPtr(), handle, type, flags, position.x, position.y, device_id));
+      base::Bind(&WindowManagerWayland::NotifyEventBatch,
+          weak_ptr_factory_.GetWeakPtr(), events));
 }
 
-void WindowManagerWayland::AxisNotify(ui::PointerPosition position,
-                                      int xoffset,
-                                      int yoffset,
-                                      int device_id) {
+void WindowManagerWayland::UpdateInputSequence(uint32_t sequence) {
+  // Messages sent from different GPU threads may arrive slightly out of
+  // order. The ring records waiting for a message which hasn't arrived yet
+  // must keep waiting, even if later messages have.
+  if (sequence != input_sequence_ + 1) {
+    if (static_cast<int32_t>(sequence - input_sequence_) > 0)
+      input_sequences_ahead_.insert(sequence);
+    return;
+  }
+
+  input_sequence_ = sequence;
+  std::set<uint32_t>::iterator it;
+  while ((it = input_sequences_ahead_.find(input_sequence_ + 1)) !=
+         input_sequences_ahead_.end()) {
+    input_sequence_ = *it;
+    input_sequences_ahead_.erase(it);
+  }
+}
+
+void WindowManagerWayland::EventBatch(
+    const std::vector<ui::InputEventRecord>& events,
+    uint32_t sequence) {
+  UpdateInputSequence(sequence);
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyAxis,
-          weak_ptr_factory_.GetWeakPtr(), position.x, position.y, xoffset, yoffset, device_id));
+      base::Bind(&WindowManagerWayland::NotifyEventBatch,
+          weak_ptr_factory_.GetWeakPtr(), events));
 }
 
 void WindowManagerWayland::PointerEnter(unsigned handle,
                                         float x,
-                                        float y) {
+                                        float y,
+                                        uint32_t sequence) {
+  UpdateInputSequence(sequence);
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
       base::Bind(&WindowManagerWayland::NotifyPointerEnter,
@@ -305,21 +442,27 @@ void WindowManagerWayland::PointerEnter(unsigned handle,
 
 void WindowManagerWayland::PointerLeave(unsigned handle,
                                         float x,
-                                        float y) {
+                                        float y,
+                                        uint32_t sequence) {
+  UpdateInputSequence(sequence);
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
       base::Bind(&WindowManagerWayland::NotifyPointerLeave,
           weak_ptr_factory_.GetWeakPtr(), handle, x, y));
 }
 
-void WindowManagerWayland::KeyboardEnter(unsigned handle) {
+void WindowManagerWayland::KeyboardEnter(unsigned handle,
+                                         uint32_t sequence) {
+  UpdateInputSequence(sequence);
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
       base::Bind(&WindowManagerWayland::NotifyKeyboardEnter,
           weak_ptr_factory_.GetWeakPtr(), handle));
 }
 
-void WindowManagerWayland::KeyboardLeave(unsigned handle) {
+void WindowManagerWayland::KeyboardLeave(unsigned handle,
+                                         uint32_t sequence) {
+  UpdateInputSequence(sequence);
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
       base::Bind(&WindowManagerWayland::NotifyKeyboardLeave,
@@ -328,13 +471,16 @@ void WindowManagerWayland::KeyboardLeave(unsigned handle) {
 
 void WindowManagerWayland::KeyNotify(EventType type,
                                      unsigned code,
-                                     int device_id) {
-  VirtualKeyNotify(type, code, device_id);
+                                     int device_id,
+                                     uint32_t sequence) {
+  VirtualKeyNotify(type, code, device_id, sequence);
 }
 
 void WindowManagerWayland::VirtualKeyNotify(EventType type,
                                             uint32_t key,
-                                            int device_id) {
+                                            int device_id,
+                                            uint32_t sequence) {
+  UpdateInputSequence(sequence);
   keyboard_.OnKeyChange(key,
                         type != ET_KEY_RELEASED,
                         false,
@@ -342,17 +488,6 @@ void WindowManagerWayland::VirtualKeyNotify(EventType type,
                         device_id);
 }
 
-void WindowManagerWayland::TouchNotify(EventType type,
-                                       ui::PointerPosition position,
-                                       int32_t touch_id,
-                                       uint32_t time_stamp,
-                                       int device_id) {
-  base::ThreadTaskRunnerHandle::Get()->PostTask(
-      FROM_HERE,
-      base::Bind(&WindowManagerWayland::NotifyTouchEvent,
-          weak_ptr_factory_.GetWeakPtr(), type, position.x, position.y, touch_id, time_stamp, device_id));
-}
-
 void WindowManagerWayland::CloseWidget(unsigned handle) {
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
@@ -377,6 +512,13 @@ void WindowManagerWayland::WindowResized(unsigned handle,
           weak_ptr_factory_.GetWeakPtr(), handle, width, height));
 }
 
+void WindowManagerWayland::WindowRenderScale(unsigned handle, float scale) {
+  base::ThreadTaskRunnerHandle::Get()->PostTask(
+      FROM_HERE,
+      base::Bind(&WindowManagerWayland::OnWindowRenderScale,
+          weak_ptr_factory_.GetWeakPtr(), handle, scale));
+}
+
 void WindowManagerWayland::WindowUnminimized(unsigned handle) {
   base::ThreadTaskRunnerHandle::Get()->PostTask(
       FROM_HERE,
@@ -459,6 +601,11 @@ void WindowManagerWayland::SeatAssignmentChanged(const std::string seat_name,
     window->SetAssignedSeat(seat);
 }
 
+void WindowManagerWayland::CursorTheme(const std::vector<int>& types) {
+  themed_cursor_types_.clear();
+  themed_cursor_types_.insert(types.begin(), types.end());
+}
+
 void WindowManagerWayland::InitializeXKB(base::SharedMemoryHandle fd,
                                          uint32_t size) {
   char* map_str =
@@ -491,6 +638,46 @@ void WindowManagerWayland::OnDispatcherListChanged() {
 }
 
 ////////////////////////////////////////////////////////////////////////////////
+void WindowManagerWayland::NotifyEventBatch(
+    const std::vector<ui::InputEventRecord>& events) {
+  for (const ui::InputEventRecord& event : events) {
+    switch (event.kind) {
+      case INPUT_MOTION_HISTORY:
+        motion_history_.push_back(event);
+        break;
+      case INPUT_MOTION:
+        NotifyMotion(event.position.x, event.position.y, event.device_id);
+        motion_history_.clear();
+        break;
+      case INPUT_BUTTON:
+        NotifyButtonPress(event.handle,
+                          static_cast<EventType>(event.type),
+                          static_cast<EventFlags>(event.flags),
+                          event.position.x,
+                          event.position.y,
+                          event.device_id);
+        break;
+      case INPUT_AXIS:
+        NotifyAxis(event.position.x,
+                   event.position.y,
+                   event.x_offset,
+                   event.y_offset,
+                   event.device_id);
+        break;
+      case INPUT_TOUCH:
+        NotifyTouchEvent(static_cast<EventType>(event.type),
+                         event.position.x,
+                         event.position.y,
+                         event.touch_id,
+                         event.time_stamp,
+                         event.device_id);
+        break;
+      default:
+        NOTREACHED();
+    }
+  }
+}
+
 void WindowManagerWayland::NotifyMotion(float x,
                                         float y,
                                         int device_id) {
@@ -610,7 +797,7 @@ void WindowManagerWayland::NotifyTouchEvent(EventType type,
 void WindowManagerWayland::NotifyOutputSizeChanged(unsigned width,
                                                    unsigned height) {
   if (platform_screen_)
-    platform_screen_->GetDelegate()->OnOutputSizeChanged(width, height);
+    platform_screen_->OnOutputSizeChanged(width, height);
 }
 
 void WindowManagerWayland::NotifyDragEnter(
@@ -7,12 +7,16 @@
 
 #include <list>
 #include <map>
+#include <memory>
+#include <set>
 #include <string>
 #include <vector>
 
 #include "base/macros.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_pump_libevent.h"
+#include "ozone/platform/input_event_ring.h"
 #include "ui/base/cursor/cursor.h"
 #include "ui/events/event.h"
 #include "ui/events/event_source.h"
@@ -32,14 +36,15 @@ namespace ui {
 class OzoneGpuPlatformSupportHost;
 class OzoneWaylandSeat;
 class OzoneWaylandWindow;
-struct PointerPosition;
+struct InputEventRecord;
 
 typedef std::map<std::string, OzoneWaylandSeat*> SeatMap;
 
 // A static class used by OzoneWaylandWindow for basic window management.
 class WindowManagerWayland
     : public PlatformEventSource,
-      public GpuPlatformSupportHost {
+      public GpuPlatformSupportHost,
+      public base::MessagePumpLibevent::Watcher {
  public:
   explicit WindowManagerWayland(OzoneGpuPlatformSupportHost* proxy);
   ~WindowManagerWayland() override;
@@ -52,6 +57,12 @@ class WindowManagerWayland
 
   PlatformCursor GetPlatformCursor();
   void SetPlatformCursor(PlatformCursor cursor);
+  // Marks the cursor |id| as the most recently used one. Returns true if the
+  // GPU process still has it cached, false if its bitmaps need to be sent.
+  bool UseCursor(uint64_t id);
+  // Returns true if the cursor theme of the GPU process has a cursor for
+  // |type| (ui::CursorType).
+  bool IsThemedCursor(int type) const;
 
   OzoneWaylandWindow* GetWindow(unsigned handle);
   bool HasWindowsOpen() const;
@@ -65,6 +76,12 @@ class WindowManagerWayland
   // Unsets a given widget as the recipient for events.
   void UngrabEvents(gfx::AcceleratedWidget widget);
 
+  // The raw motion samples the GPU process merged into the mouse move being
+  // dispatched, oldest first. Empty outside of its dispatch.
+  const std::vector<InputEventRecord>& motion_history() const {
+    return motion_history_;
+  }
+
  private:
   void OnActivationChanged(unsigned windowhandle, bool active);
   std::list<OzoneWaylandWindow*>& open_windows();
@@ -76,6 +93,7 @@ class WindowManagerWayland
                        unsigned width,
                        unsigned height);
   void OnWindowUnminimized(unsigned windowhandle);
+  void OnWindowRenderScale(unsigned windowhandle, float scale);
   void OnWindowDeActivated(unsigned windowhandle);
   void OnWindowActivated(unsigned windowhandle);
   // GpuPlatformSupportHost
@@ -85,29 +103,35 @@ class WindowManagerWayland
       const base::Callback<void(IPC::Message*)>& send_callback) override;
   void OnChannelDestroyed(int host_id) override;
   bool OnMessageReceived(const IPC::Message&) override;
-  void MotionNotify(ui::PointerPosition position, int device_id);
-  void ButtonNotify(unsigned handle,
-                    EventType type,
-                    EventFlags flags,
-                    ui::PointerPosition position,
-                    int device_id);
-  void AxisNotify(ui::PointerPosition position,
-                  int xoffset,
-                  int yoffset,
-                  int device_id);
-  void PointerEnter(unsigned handle, float x, float y);
-  void PointerLeave(unsigned handle, float x, float y);
-  void KeyboardEnter(unsigned handle);
-  void KeyboardLeave(unsigned handle);
-  void KeyNotify(EventType type, unsigned code, int device_id);
+
+  // base::MessagePumpLibevent::Watcher:
+  void OnFileCanReadWithoutBlocking(int fd) override;
+  void OnFileCanWriteWithoutBlocking(int fd) override;
+
+  // Opt-in (OZONE_WAYLAND_INPUT_RING) shared memory transport for pointer and
+  // touch events, see InputEventRing.
+  void SetupInputRing();
+  void ResetInputRing();
+  // Posts the records of the ring which don't wait for a message still to
+  // be received.
+  void DrainInputRing();
+  // Records that the input message or batch |sequence| has been handled.
+  void UpdateInputSequence(uint32_t sequence);
+
+  void EventBatch(const std::vector<ui::InputEventRecord>& events,
+                  uint32_t sequence);
+  void PointerEnter(unsigned handle, float x, float y, uint32_t sequence);
+  void PointerLeave(unsigned handle, float x, float y, uint32_t sequence);
+  void KeyboardEnter(unsigned handle, uint32_t sequence);
+  void KeyboardLeave(unsigned handle, uint32_t sequence);
+  void KeyNotify(EventType type,
+                 unsigned code,
+                 int device_id,
+                 uint32_t sequence);
   void VirtualKeyNotify(EventType type,
                         uint32_t key,
-                        int device_id);
-  void TouchNotify(EventType type,
-                   ui::PointerPosition position,
-                   int32_t touch_id,
-                   uint32_t time_stamp,
-                   int device_id);
+                        int device_id,
+                        uint32_t sequence);
   void CloseWidget(unsigned handle);
 
   void OutputSizeChanged(unsigned width, unsigned height);
@@ -115,6 +139,7 @@ class WindowManagerWayland
                      unsigned width,
                      unsigned height);
   void WindowUnminimized(unsigned windowhandle);
+  void WindowRenderScale(unsigned windowhandle, float scale);
   void WindowDeActivated(unsigned windowhandle);
   void WindowActivated(unsigned windowhandle);
 
@@ -134,6 +159,7 @@ class WindowManagerWayland
                              unsigned windowhandle);
 
   void InitializeXKB(base::SharedMemoryHandle fd, uint32_t size);
+  void CursorTheme(const std::vector<int>& types);
   // PlatformEventSource:
   void OnDispatcherListChanged() override;
 
@@ -142,6 +168,8 @@ class WindowManagerWayland
   // Post a task to dispatch an event.
   void PostUiEvent(Event* event);
 
+  // Dispatches the events of a WaylandInput_EventBatch in order.
+  void NotifyEventBatch(const std::vector<ui::InputEventRecord>& events);
   void NotifyMotion(float x,
                     float y,
                     int device_id);
@@ -195,6 +223,20 @@ class WindowManagerWayland
   KeyboardEvdev keyboard_;
   ozonewayland::OzoneWaylandScreen* platform_screen_;
   PlatformCursor platform_cursor_;
+  // Ids of the cursors cached by the GPU process, most recently used first.
+  // This mirrors WaylandCursorCache, which evicts in the same order.
+  std::list<uint64_t> cached_cursors_;
+  std::set<int> themed_cursor_types_;
+  std::unique_ptr<base::SharedMemory> input_ring_memory_;
+  InputEventRing input_ring_;
+  int input_ring_fd_;
+  base::MessagePumpLibevent::FileDescriptorWatcher input_ring_watcher_;
+  // Sequence number of the input messages and batches handled since the
+  // channel was established, up to which none is missing.
+  uint32_t input_sequence_;
+  // Sequence numbers handled after |input_sequence_| + 1, which is missing.
+  std::set<uint32_t> input_sequences_ahead_;
+  std::vector<InputEventRecord> motion_history_;
   // Support weak pointers for attach & detach callbacks.
   base::WeakPtrFactory<WindowManagerWayland> weak_ptr_factory_;
   DISALLOW_COPY_AND_ASSIGN(WindowManagerWayland);
@@ -9,16 +9,19 @@
 
 #include "base/bind.h"
 #include "base/memory/ptr_util.h"
+#include "ozone/platform/ozone_wayland_window.h"
 #include "ozone/ui/desktop_aura/desktop_drag_drop_client_wayland.h"
 #include "ozone/ui/desktop_aura/desktop_screen_wayland.h"
 #include "ui/aura/client/focus_client.h"
 #include "ui/aura/window_property.h"
 #include "ui/base/hit_test.h"
 #include "ui/base/ime/input_method.h"
+#include "ui/compositor/compositor.h"
 #include "ui/display/display.h"
 #include "ui/display/screen.h"
 #include "ui/events/platform/platform_event_source.h"
 #include "ui/gfx/geometry/insets.h"
+#include "ui/gfx/geometry/size_conversions.h"
 #include "ui/gfx/path.h"
 #include "ui/native_theme/native_theme.h"
 #include "ui/ozone/public/ozone_platform.h"
@@ -57,6 +60,7 @@ DesktopWindowTreeHostOzone::DesktopWindowTreeHostOzone(
       has_capture_(false),
       custom_window_shape_(false),
       always_on_top_(false),
+      render_scale_(1.0f),
       previous_bounds_(0, 0, 0, 0),
       previous_maximize_bounds_(0, 0, 0, 0),
       window_(0),
@@ -625,12 +629,21 @@ gfx::Transform DesktopWindowTreeHostOzone::GetRootTransform() const {
   aura::Window* win = const_cast<aura::Window*>(window());
   display = display::Screen::GetScreen()->GetDisplayNearestWindow(win);
 
+  // The scale factor of the compositor includes the render scale, events and
+  // bounds stay in window pixels whatever the window is rendered at.
   float scale = display.device_scale_factor();
   gfx::Transform transform;
   transform.Scale(scale, scale);
   return transform;
 }
 
+gfx::Transform DesktopWindowTreeHostOzone::GetInverseRootTransform() const {
+  gfx::Transform invert;
+  if (!GetRootTransform().GetInverse(&invert))
+    return gfx::Transform();
+  return invert;
+}
+
 ui::EventSource* DesktopWindowTreeHostOzone::GetEventSource() {
   return this;
 }
@@ -720,6 +733,8 @@ void DesktopWindowTreeHostOzone::OnBoundsChanged(
   // TODO(kalyan): Add support to check if origin has really changed.
   native_widget_delegate_->AsWidget()->OnNativeWidgetMove();
   OnHostResized(new_bounds.size());
+  if (render_scale_ != 1.0f)
+    UpdateCompositorScale();
   ResetWindowRegion();
 }
 
@@ -893,6 +908,10 @@ void DesktopWindowTreeHostOzone::InitOzoneWindow(
   platform_window_ =
       ui::OzonePlatform::GetInstance()->CreatePlatformWindow(this, bounds);
   DCHECK(window_);
+  static_cast<ui::OzoneWaylandWindow*>(platform_window_.get())->
+      SetRenderScaleCallback(
+          base::Bind(&DesktopWindowTreeHostOzone::OnRenderScaleChanged,
+                     base::Unretained(this)));
   // Maintain parent child relation as done in X11 version.
   // If we have a parent, record the parent/child relationship. We use this
   // data during destruction to make sure that when we try to close a parent
@@ -1004,6 +1023,25 @@ gfx::Rect DesktopWindowTreeHostOzone::ToPixelRect(
   return gfx::ToEnclosingRect(rect_in_pixels);
 }
 
+void DesktopWindowTreeHostOzone::OnRenderScaleChanged(float scale) {
+  render_scale_ = scale;
+  UpdateCompositorScale();
+}
+
+void DesktopWindowTreeHostOzone::UpdateCompositorScale() {
+  if (!compositor())
+    return;
+
+  // The GPU process stretches the smaller frame back to the window size, so
+  // only the compositor learns about the render scale.
+  aura::Window* win = const_cast<aura::Window*>(window());
+  float device_scale = display::Screen::GetScreen()->
+      GetDisplayNearestWindow(win).device_scale_factor();
+  compositor()->SetScaleAndSize(
+      device_scale * render_scale_,
+      gfx::ScaleToCeiledSize(GetBounds().size(), render_scale_));
+}
+
 void DesktopWindowTreeHostOzone::ResetWindowRegion() {
   if (custom_window_shape_)
     return;
@@ -124,6 +124,7 @@ class VIEWS_EXPORT DesktopWindowTreeHostOzone
 
   // Overridden from aura::WindowTreeHost:
   gfx::Transform GetRootTransform() const override;
+  gfx::Transform GetInverseRootTransform() const override;
   ui::EventSource* GetEventSource() override;
   gfx::AcceleratedWidget GetAcceleratedWidget() override;
   void ShowImpl() override;
@@ -182,12 +183,16 @@ class VIEWS_EXPORT DesktopWindowTreeHostOzone
   static std::list<gfx::AcceleratedWidget>& open_windows();
   gfx::Rect ToDIPRect(const gfx::Rect& rect_in_pixels) const;
   gfx::Rect ToPixelRect(const gfx::Rect& rect_in_dip) const;
+  // Called when the GPU process changes the scale the window is rendered at.
+  void OnRenderScaleChanged(float scale);
+  void UpdateCompositorScale();
   void ResetWindowRegion();
 
   RootWindowState state_;
   bool has_capture_;
   bool custom_window_shape_;
   bool always_on_top_;
+  float render_scale_;
 
   // Original bounds of DRWH.
   gfx::Rect previous_bounds_;
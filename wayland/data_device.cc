@@ -24,6 +24,10 @@ WaylandDataDevice::WaylandDataDevice(WaylandDisplay* display, wl_seat* seat)
     WaylandDataDevice::OnDrop,
     WaylandDataDevice::OnSelection
   };
+  // Drag and drop events are dispatched along with the pointer events. The
+  // data offers inherit the queue of the data device.
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(&data_device_),
+                     display->GetInputQueue());
   wl_data_device_add_listener(&data_device_, &kDataDeviceListener, this);
 }
 
@@ -8,20 +8,28 @@
 #include <EGL/egl.h>
 #include <errno.h>
 #include <fcntl.h>
+#include <time.h>
 #if defined(ENABLE_DRM_SUPPORT)
 #include <gbm.h>
 #include <libdrm/drm.h>
 #include <xf86drm.h>
 #endif
+#include <algorithm>
 #include <string>
+#include <utility>
 
 #include "base/bind.h"
 #include "base/files/file_path.h"
 #include "base/message_loop/message_loop.h"
 #include "base/native_library.h"
+#include "base/posix/eintr_wrapper.h"
 #include "base/stl_util.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/trace_event/trace_event.h"
 #include "ipc/ipc_sender.h"
 #include "ozone/platform/messages.h"
+#include "ozone/platform/surface_ozone_canvas_host.h"
 #include "ozone/wayland/data_device.h"
 #include "ozone/wayland/display_poll_thread.h"
 #include "ozone/wayland/egl/surface_ozone_wayland.h"
@@ -29,6 +37,12 @@
 #include "ozone/wayland/egl/wayland_pixmap.h"
 #endif
 #include "ozone/wayland/input/cursor.h"
+#include "ozone/wayland/input/cursor_cache.h"
+#include "ozone/wayland/input/cursor_theme.h"
+#include "ozone/wayland/input/event_coalescer.h"
+#include "ozone/wayland/lock_free_queue.h"
+#include "ozone/wayland/protocol/presentation-time-client-protocol.h"
+#include "ozone/wayland/protocol/viewporter-client-protocol.h"
 #include "ozone/wayland/protocol/text-client-protocol.h"
 #if defined(ENABLE_DRM_SUPPORT)
 #include "ozone/wayland/protocol/wayland-drm-protocol.h"
@@ -36,7 +50,11 @@
 #include "ozone/wayland/screen.h"
 #include "ozone/wayland/seat.h"
 #include "ozone/wayland/shell/shell.h"
+#include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/shm_arena.h"
+#include "ozone/wayland/surface_ozone_canvas_wayland.h"
 #include "ozone/wayland/window.h"
+#include "third_party/skia/include/core/SkCanvas.h"
 #include "ui/ozone/public/native_pixmap.h"
 #include "ui/ozone/public/surface_ozone_canvas.h"
 
@@ -76,28 +94,71 @@ static const struct wl_drm_listener drm_listener = {
 #endif
 
 namespace ozonewayland {
+namespace {
+
+// Longest motion and axis events wait for a frame callback before they are
+// sent anyway, for windows the compositor doesn't repaint.
+const int kMaxInputHoldMs = 16;
+// Number of messages which can wait for the main loop before Dispatch blocks.
+const size_t kMessageQueueCapacity = 256;
+
+}  // namespace
+
+struct WaylandDisplay::RemoteCanvas {
+  // NULL while the browser has no canvas for the window.
+  std::unique_ptr<SurfaceOzoneCanvasWayland> canvas;
+  // The memory the browser renders the frames into, see SetCanvasMemory.
+  std::unique_ptr<base::SharedMemory> pixels;
+  gfx::Size size;
+};
+
 WaylandDisplay* WaylandDisplay::instance_ = NULL;
 
 WaylandDisplay::WaylandDisplay() : SurfaceFactoryOzone(),
     display_(NULL),
     registry_(NULL),
+    input_queue_(NULL),
     compositor_(NULL),
+    subcompositor_(NULL),
     data_device_manager_(NULL),
     shell_(NULL),
     shm_(NULL),
+    presentation_(NULL),
+    presentation_clock_id_(CLOCK_MONOTONIC),
+    viewporter_(NULL),
     text_input_manager_(NULL),
+    text_input_manager_name_(0),
+    globals_sync_(NULL),
+    globals_ready_(base::WaitableEvent::ResetPolicy::MANUAL,
+                   base::WaitableEvent::InitialState::NOT_SIGNALED),
     primary_screen_(NULL),
     primary_seat_(NULL),
-    display_poll_thread_(NULL),
+    display_thread_(NULL),
+    input_poll_thread_(NULL),
     device_(NULL),
     m_deviceName(NULL),
     sender_(NULL),
+    canvas_sender_(NULL),
     loop_(NULL),
     screen_list_(),
     seat_list_(),
     widget_map_(),
     serial_(0),
+    window_dispatch_pending_(0),
+    default_dispatch_pending_(0),
+    events_read_cv_(&events_read_lock_),
+    events_read_count_(0),
+    message_queue_(new LockFreeQueue<IPC::Message*>(kMessageQueueCapacity)),
+    message_drain_pending_(0),
+    message_queue_high_watermark_(0),
+    input_events_(new WaylandEventCoalescer()),
+    frames_in_flight_(0),
+    input_ring_fd_(-1),
+    input_sequence_(0),
+    flush_scheduled_(false),
     processing_events_(false),
+    globals_bound_(false),
+    first_frame_swapped_(false),
     m_authenticated_(false),
     m_fd_(-1),
     m_capabilities_(0),
@@ -116,12 +177,138 @@ WaylandWindow* WaylandDisplay::GetWindow(unsigned window_handle) const {
   return GetWidget(window_handle);
 }
 
-struct wl_text_input_manager* WaylandDisplay::GetTextInputManager() const {
+struct wl_text_input_manager* WaylandDisplay::GetTextInputManager() {
+  // Only bound when the first text input is created.
+  if (!text_input_manager_ && text_input_manager_name_) {
+    text_input_manager_ = static_cast<wl_text_input_manager*>(
+        wl_registry_bind(registry_,
+                         text_input_manager_name_,
+                         &wl_text_input_manager_interface,
+                         1));
+  }
+
   return text_input_manager_;
 }
 
+bool WaylandDisplay::WaitForGlobals() {
+  if (globals_bound_)
+    return true;
+
+  TRACE_EVENT0("ozone", "WaylandDisplay::WaitForGlobals");
+  // Check the connection every now and then, GlobalsSyncDone won't ever be
+  // called if it has been lost.
+  const base::TimeDelta kCheckInterval = base::TimeDelta::FromMilliseconds(50);
+  while (!globals_ready_.TimedWait(kCheckInterval)) {
+    if (wl_display_get_error(display_)) {
+      LOG(ERROR) << "Lost the connection while binding Wayland globals.";
+      return false;
+    }
+  }
+
+  globals_bound_ = true;
+  return true;
+}
+
+void WaylandDisplay::LoadCursorTheme() {
+  if (!shm_)
+    return;
+
+  // The cursor surface can only take buffers of the output scale from
+  // version 3 of wl_compositor on.
+  int scale = 1;
+  if (wl_proxy_get_version(reinterpret_cast<wl_proxy*>(compositor_)) >=
+      WL_SURFACE_SET_BUFFER_SCALE_SINCE_VERSION) {
+    for (WaylandScreen* screen : screen_list_)
+      scale = std::max(scale, static_cast<int>(screen->Scale()));
+  }
+
+  cursor_theme_.reset(new WaylandCursorTheme());
+  if (!cursor_theme_->Load(shm_, scale))
+    cursor_theme_.reset();
+}
+
+void WaylandDisplay::OnFrameSwapped() {
+  if (first_frame_swapped_)
+    return;
+
+  first_frame_swapped_ = true;
+  TRACE_EVENT_ASYNC_END0("ozone", "WaylandDisplay::TimeToFirstFrame", this);
+}
+
+size_t WaylandDisplay::message_queue_depth() const {
+  return message_queue_->Size();
+}
+
+base::TimeTicks WaylandDisplay::PresentationTimeToTimeTicks(
+    uint64_t seconds,
+    uint32_t nanoseconds) const {
+  base::TimeDelta time = base::TimeDelta::FromSeconds(seconds) +
+      base::TimeDelta::FromMicroseconds(
+          nanoseconds / base::Time::kNanosecondsPerMicrosecond);
+  // TimeTicks use CLOCK_MONOTONIC, which is what compositors normally use.
+  if (presentation_clock_id_ == CLOCK_MONOTONIC)
+    return base::TimeTicks() + time;
+
+  struct timespec now;
+  if (clock_gettime(static_cast<clockid_t>(presentation_clock_id_), &now) < 0)
+    return base::TimeTicks::Now();
+
+  base::TimeDelta clock_now = base::TimeDelta::FromSeconds(now.tv_sec) +
+      base::TimeDelta::FromMicroseconds(
+          now.tv_nsec / base::Time::kNanosecondsPerMicrosecond);
+  return base::TimeTicks::Now() - (clock_now - time);
+}
+
 void WaylandDisplay::FlushDisplay() {
-  wl_display_flush(display_);
+  // Never wait for a slow compositor here, the input thread takes over and
+  // sends the rest once the socket is writable.
+  if (wl_display_flush(display_) < 0 && errno == EAGAIN &&
+      input_poll_thread_) {
+    input_poll_thread_->RequestFlush();
+  }
+}
+
+int WaylandDisplay::flush_stall_count() const {
+  return input_poll_thread_ ? input_poll_thread_->flush_stalls() : 0;
+}
+
+uint32_t WaylandDisplay::events_read_count() {
+  base::AutoLock lock(events_read_lock_);
+  return events_read_count_;
+}
+
+bool WaylandDisplay::WaitForEventsRead(uint32_t count,
+                                       base::TimeTicks deadline) {
+  base::AutoLock lock(events_read_lock_);
+  while (events_read_count_ == count) {
+    base::TimeDelta timeout = deadline - base::TimeTicks::Now();
+    if (timeout <= base::TimeDelta())
+      return false;
+
+    events_read_cv_.TimedWait(timeout);
+  }
+
+  return true;
+}
+
+void WaylandDisplay::ScheduleFlush() {
+  if (!loop_ || base::MessageLoop::current() != loop_) {
+    FlushDisplay();
+    return;
+  }
+
+  flush_scheduled_ = true;
+}
+
+void WaylandDisplay::WillProcessTask(const base::PendingTask& pending_task) {
+}
+
+void WaylandDisplay::DidProcessTask(const base::PendingTask& pending_task) {
+  if (!flush_scheduled_)
+    return;
+
+  flush_scheduled_ = false;
+  FlushDisplay();
 }
 
 void WaylandDisplay::DestroyWindow(unsigned w) {
@@ -135,6 +322,7 @@ void WaylandDisplay::DestroyWindow(unsigned w) {
 }
 
 gfx::AcceleratedWidget WaylandDisplay::GetNativeWindow(unsigned window_handle) {
+  WaitForGlobals();
   WaylandWindow* widget = GetWidget(window_handle);
   DCHECK(widget);
   widget->RealizeAcceleratedWidget();
@@ -143,6 +331,7 @@ gfx::AcceleratedWidget WaylandDisplay::GetNativeWindow(unsigned window_handle) {
 }
 
 bool WaylandDisplay::InitializeHardware() {
+  TRACE_EVENT_ASYNC_BEGIN0("ozone", "WaylandDisplay::TimeToFirstFrame", this);
   InitializeDisplay();
   if (!display_) {
     LOG(ERROR) << "WaylandDisplay failed to initialize hardware";
@@ -152,6 +341,10 @@ bool WaylandDisplay::InitializeHardware() {
   // Ensure we are processing wayland event requests. This needs to be done here
   // so we start polling before sandbox is initialized.
   StartProcessingEvents();
+  // The theme files can't be read anymore once the sandbox is engaged.
+  if (WaitForGlobals())
+    LoadCursorTheme();
+
   return true;
 }
 
@@ -230,20 +423,18 @@ scoped_refptr<ui::NativePixmap> WaylandDisplay::CreateNativePixmap(
 
 std::unique_ptr<ui::SurfaceOzoneCanvas> WaylandDisplay::CreateCanvasForWidget(
     gfx::AcceleratedWidget widget) {
-  LOG(FATAL) << "The browser process has attempted to start the GPU process in "
-             << "software rendering mode. Software rendering is not supported "
-             << "in Ozone-Wayland, so this is fatal. Usually this error occurs "
-             << "because the GPU process crashed in hardware rendering mode, "
-             << "often due to failure to initialize EGL. To debug the GPU "
-             << "process, start Chrome with --gpu-startup-dialog so that the "
-             << "GPU process pauses on startup, then attach to it with "
-             << "'gdb -p' and run the command 'signal SIGUSR1' in order to "
-             << "unpause it. If you have xterm then it is easier to run "
-             << "'chrome --no-sandbox --gpu-launcher='xterm -title renderer "
-             << "-e gdb --eval-command=run --args''";
-
-  // This code will obviously never be reached, but it placates -Wreturn-type.
-  return std::unique_ptr<ui::SurfaceOzoneCanvas>();
+  if (canvas_sender_) {
+    return std::unique_ptr<ui::SurfaceOzoneCanvas>(
+        new ui::SurfaceOzoneCanvasHost(widget, canvas_sender_));
+  }
+
+  if (!display_ || !shm_) {
+    LOG(FATAL) << "Software rendering needs a Wayland connection with wl_shm.";
+    return std::unique_ptr<ui::SurfaceOzoneCanvas>();
+  }
+
+  return std::unique_ptr<ui::SurfaceOzoneCanvas>(
+      new SurfaceOzoneCanvasWayland(widget, true));
 }
 
 void WaylandDisplay::InitializeDisplay() {
@@ -253,6 +444,7 @@ void WaylandDisplay::InitializeDisplay() {
     return;
 
   instance_ = this;
+  input_queue_ = wl_display_create_queue(display_);
   static const struct wl_registry_listener registry_all = {
     WaylandDisplay::DisplayHandleGlobal
   };
@@ -260,13 +452,36 @@ void WaylandDisplay::InitializeDisplay() {
   registry_ = wl_display_get_registry(display_);
   wl_registry_add_listener(registry_, &registry_all, this);
   shell_ = new WaylandShell();
+  shm_arena_.reset(new WaylandShmArena());
+  shm_arena_->Initialize();
+  cursor_cache_.reset(new WaylandCursorCache());
+
+  // The globals are bound by the display thread as soon as it starts,
+  // while this thread goes on loading EGL. The sync callbacks tell when all of
+  // them have been announced and have sent their initial state, see
+  // WaitForGlobals.
+  static const struct wl_callback_listener globals_sync_listener = {
+    WaylandDisplay::GlobalsSyncDone
+  };
 
-  if (wl_display_roundtrip(display_) < 0) {
-    Terminate();
-    return;
-  }
+  TRACE_EVENT_ASYNC_BEGIN0("ozone", "WaylandDisplay::BindGlobals", this);
+  globals_sync_ = wl_display_sync(display_);
+  wl_callback_add_listener(globals_sync_, &globals_sync_listener, this);
 
-  display_poll_thread_ = new WaylandDisplayPollThread(display_);
+  display_thread_ = new base::Thread("WaylandDisplayThread");
+  input_poll_thread_ = new WaylandDisplayPollThread(
+      "WaylandInputThread",
+      display_,
+      input_queue_,
+      base::Bind(&WaylandDisplay::OnInputEventsRead,
+                 base::Unretained(this)));
+  input_poll_thread_->SetPollTimeoutCallback(
+      base::Bind(&WaylandDisplay::GetInputPollTimeout,
+                 base::Unretained(this)));
+
+  char *env;
+  if ((env = getenv("OZONE_WAYLAND_INPUT_THREAD_CPU")))
+    input_poll_thread_->SetCpuAffinity(atoi(env));
 }
 
 WaylandWindow* WaylandDisplay::CreateAcceleratedSurface(unsigned w) {
@@ -277,25 +492,154 @@ WaylandWindow* WaylandDisplay::CreateAcceleratedSurface(unsigned w) {
 }
 
 void WaylandDisplay::StartProcessingEvents() {
-  DCHECK(display_poll_thread_);
-  // Start polling for wayland events.
+  DCHECK(display_thread_ && input_poll_thread_);
+  // Start polling for wayland events. Input is latency sensitive, everything
+  // else (outputs, globals, shell events) is not. A single thread reads the
+  // display: wl_display_read_events waits for every thread which prepared a
+  // read, so a background reader would hold the input up.
   if (!processing_events_) {
-    display_poll_thread_->StartProcessingEvents();
+    base::Thread::Options options;
+    options.priority = base::ThreadPriority::BACKGROUND;
+    display_thread_->StartWithOptions(options);
+    input_poll_thread_->StartProcessingEvents(base::ThreadPriority::DISPLAY);
     processing_events_ = true;
   }
 }
 
 void WaylandDisplay::StopProcessingEvents() {
-  DCHECK(display_poll_thread_);
+  DCHECK(display_thread_ && input_poll_thread_);
   // Start polling for wayland events.
   if (processing_events_) {
-    display_poll_thread_->StopProcessingEvents();
+    input_poll_thread_->StopProcessingEvents();
+    display_thread_->Stop();
     processing_events_ = false;
   }
 }
 
+void WaylandDisplay::ScheduleWindowQueuesDispatch() {
+  if (!loop_)
+    return;
+
+  if (base::subtle::NoBarrier_CompareAndSwap(&window_dispatch_pending_, 0, 1))
+    return;
+
+  loop_->task_runner()->PostTask(FROM_HERE,
+      base::Bind(&WaylandDisplay::DispatchWindowQueues,
+                 weak_ptr_factory_.GetWeakPtr()));
+}
+
+void WaylandDisplay::ScheduleDefaultQueueDispatch() {
+  if (base::subtle::NoBarrier_CompareAndSwap(&default_dispatch_pending_, 0, 1))
+    return;
+
+  display_thread_->task_runner()->PostTask(FROM_HERE,
+      base::Bind(&WaylandDisplay::DispatchDefaultQueue,
+                 base::Unretained(this)));
+}
+
+void WaylandDisplay::DispatchDefaultQueue() {
+  base::subtle::Release_Store(&default_dispatch_pending_, 0);
+  wl_display_dispatch_pending(display_);
+  // Requests made by the handlers, e.g. the bound globals.
+  FlushDisplay();
+}
+
+void WaylandDisplay::FrameCommitted() {
+  base::subtle::NoBarrier_AtomicIncrement(&frames_in_flight_, 1);
+}
+
+void WaylandDisplay::FramesDone(size_t count) {
+  if (!count)
+    return;
+
+  base::subtle::Barrier_AtomicIncrement(
+      &frames_in_flight_, -static_cast<base::subtle::Atomic32>(count));
+  // The input thread sends the events it held back for the frame.
+  if (input_poll_thread_)
+    input_poll_thread_->WakeUp();
+}
+
+void WaylandDisplay::SeatAcceptanceChanged(unsigned windowhandle) {
+  {
+    base::AutoLock lock(seat_acceptance_lock_);
+    seat_acceptance_changes_.insert(windowhandle);
+  }
+
+  if (input_poll_thread_)
+    input_poll_thread_->WakeUp();
+}
+
+void WaylandDisplay::OnInputEventsRead() {
+  std::set<unsigned> seat_acceptance_changes;
+  {
+    base::AutoLock lock(seat_acceptance_lock_);
+    seat_acceptance_changes.swap(seat_acceptance_changes_);
+  }
+
+  for (unsigned handle : seat_acceptance_changes) {
+    WaylandWindow* window = GetWindow(handle);
+    if (window)
+      window->ShellSurface()->UpdateSeatAcceptance();
+  }
+
+  // Only the latest position matters to the next frame, so while frames are
+  // waiting for the compositor motion and axis events keep being merged. They
+  // are sent once a frame is done, right before the browser starts the next
+  // one, or as they are read when no frame is in flight.
+  bool flush;
+  {
+    base::AutoLock lock(input_events_lock_);
+    flush = input_events_->HasPendingEvents() &&
+        (!base::subtle::Acquire_Load(&frames_in_flight_) ||
+         base::TimeTicks::Now() - input_events_->first_event_time() >=
+             base::TimeDelta::FromMilliseconds(kMaxInputHoldMs));
+  }
+
+  if (flush)
+    FlushInputEvents();
+
+  ScheduleDefaultQueueDispatch();
+  ScheduleWindowQueuesDispatch();
+  {
+    base::AutoLock lock(events_read_lock_);
+    ++events_read_count_;
+  }
+
+  events_read_cv_.Broadcast();
+}
+
+int WaylandDisplay::GetInputPollTimeout() {
+  base::AutoLock lock(input_events_lock_);
+  if (!input_events_->HasPendingEvents())
+    return -1;
+
+  base::TimeDelta remaining =
+      base::TimeDelta::FromMilliseconds(kMaxInputHoldMs) -
+      (base::TimeTicks::Now() - input_events_->first_event_time());
+  return std::max(0, static_cast<int>(remaining.InMillisecondsRoundedUp()));
+}
+
+void WaylandDisplay::QueueInputEvent(const ui::InputEventRecord& event) {
+  base::AutoLock lock(input_events_lock_);
+  input_events_->Queue(event);
+}
+
+void WaylandDisplay::DispatchWindowQueues() {
+  base::subtle::Release_Store(&window_dispatch_pending_, 0);
+  for (const auto& widget : widget_map_)
+    widget.second->DispatchEventQueue();
+}
+
 void WaylandDisplay::Terminate() {
-  loop_ = NULL;
+  if (loop_ && base::MessageLoop::current() == loop_)
+    loop_->RemoveTaskObserver(this);
+
+  {
+    base::AutoLock lock(deferred_messages_lock_);
+    loop_ = NULL;
+  }
+
+  canvases_.clear();
   if (!widget_map_.empty()) {
     STLDeleteValues(&widget_map_);
     widget_map_.clear();
@@ -330,14 +674,37 @@ void WaylandDisplay::Terminate() {
   if (compositor_)
     wl_compositor_destroy(compositor_);
 
+  if (subcompositor_)
+    wl_subcompositor_destroy(subcompositor_);
+
   delete shell_;
+  cursor_theme_.reset();
+  cursor_cache_.reset();
+  shm_arena_.reset();
   if (shm_)
     wl_shm_destroy(shm_);
 
+  if (presentation_)
+    wp_presentation_destroy(presentation_);
+
+  if (viewporter_)
+    wp_viewporter_destroy(viewporter_);
+
+  if (globals_sync_)
+    wl_callback_destroy(globals_sync_);
+
   if (registry_)
     wl_registry_destroy(registry_);
 
-  delete display_poll_thread_;
+  delete input_poll_thread_;
+  input_poll_thread_ = NULL;
+  delete display_thread_;
+  display_thread_ = NULL;
+
+  if (input_queue_) {
+    wl_event_queue_destroy(input_queue_);
+    input_queue_ = NULL;
+  }
 
   if (display_) {
     wl_display_flush(display_);
@@ -345,9 +712,17 @@ void WaylandDisplay::Terminate() {
     display_ = NULL;
   }
 
-  while (!deferred_messages_.empty())
-    deferred_messages_.pop();
+  {
+    base::AutoLock lock(deferred_messages_lock_);
+    while (!deferred_messages_.empty())
+      deferred_messages_.pop();
+  }
+
+  IPC::Message* message;
+  while (message_queue_->Pop(&message))
+    delete message;
 
+  ResetInputRing();
   instance_ = NULL;
 }
 
@@ -400,6 +775,14 @@ void WaylandDisplay::SetWidgetState(unsigned w, ui::WidgetState state) {
       widget->Hide();
       break;
     }
+    case ui::DESTROYED:
+    {
+      // The windows of the canvases outlive them, see DestroyCanvas. The
+      // others go with their EGL surface.
+      if (canvases_.erase(w) && GetWidget(w))
+        DestroyWindow(w);
+      break;
+    }
     default:
       break;
   }
@@ -471,23 +854,114 @@ void WaylandDisplay::MoveWindow(unsigned widget,
   popup->Move(shell_type, shell_parent, rect);
 }
 
-void WaylandDisplay::AddRegion(unsigned handle, int left, int top,
-                               int right, int bottom) {
+void WaylandDisplay::SetRegion(unsigned handle,
+                               const std::vector<gfx::Rect>& rects) {
   WaylandWindow* widget = GetWidget(handle);
   DCHECK(widget);
-  widget->AddRegion(left, top, right, bottom);
+  widget->SetRegion(rects);
 }
 
-void WaylandDisplay::SubRegion(unsigned handle, int left, int top,
-                               int right, int bottom) {
+void WaylandDisplay::SetRenderScale(unsigned handle,
+                                    float scale,
+                                    const gfx::Size& logical_size) {
   WaylandWindow* widget = GetWidget(handle);
   DCHECK(widget);
-  widget->SubRegion(left, top, right, bottom);
+  widget->SetRenderScale(scale, logical_size);
+}
+
+void WaylandDisplay::SetCanvasMemory(unsigned handle,
+                                     const gfx::Size& size,
+                                     base::SharedMemoryHandle pixels) {
+  std::unique_ptr<base::SharedMemory> memory(
+      new base::SharedMemory(pixels, true));
+  size_t stride =
+      SkImageInfo::MakeN32Premul(size.width(), size.height()).minRowBytes();
+  if (size.IsEmpty() || !memory->Map(stride * size.height())) {
+    LOG(ERROR) << "Failed to map the canvas memory.";
+    return;
+  }
+
+  std::unique_ptr<RemoteCanvas>& canvas = canvases_[handle];
+  if (!canvas)
+    canvas.reset(new RemoteCanvas());
+  if (!canvas->canvas)
+    canvas->canvas.reset(new SurfaceOzoneCanvasWayland(handle, false));
+
+  canvas->pixels = std::move(memory);
+  canvas->size = size;
+  canvas->canvas->ResizeCanvas(size);
+}
+
+void WaylandDisplay::PresentCanvas(unsigned handle, const gfx::Rect& damage) {
+  std::map<unsigned, std::unique_ptr<RemoteCanvas>>::iterator it =
+      canvases_.find(handle);
+  if (it == canvases_.end() || !it->second->canvas)
+    return;
+
+  RemoteCanvas* canvas = it->second.get();
+  gfx::Rect damaged_rect = gfx::IntersectRects(damage, gfx::Rect(canvas->size));
+  if (damaged_rect.IsEmpty())
+    return;
+
+  sk_sp<SkSurface> surface = canvas->canvas->GetSurface();
+  if (!surface)
+    return;
+
+  // Only the damaged rect is copied out of the canvas memory.
+  SkImageInfo info = SkImageInfo::MakeN32Premul(damaged_rect.width(),
+                                                damaged_rect.height());
+  size_t stride = SkImageInfo::MakeN32Premul(canvas->size.width(),
+                                             canvas->size.height())
+                      .minRowBytes();
+  const uint8_t* pixels =
+      static_cast<const uint8_t*>(canvas->pixels->memory()) +
+      damaged_rect.y() * stride + damaged_rect.x() * info.bytesPerPixel();
+  surface->getCanvas()->writePixels(info, pixels, stride,
+                                    damaged_rect.x(), damaged_rect.y());
+  canvas->canvas->PresentCanvas(damaged_rect);
+}
+
+void WaylandDisplay::DestroyCanvas(unsigned handle) {
+  // The window stays, a new canvas may be created for it.
+  std::map<unsigned, std::unique_ptr<RemoteCanvas>>::iterator it =
+      canvases_.find(handle);
+  if (it == canvases_.end())
+    return;
+
+  it->second->canvas.reset();
+  it->second->pixels.reset();
 }
 
 void WaylandDisplay::SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                                     const gfx::Point& location) {
-  primary_seat_->SetCursorBitmap(bitmaps, location);
+                                     const gfx::Point& location,
+                                     int frame_delay_ms,
+                                     uint64_t id) {
+  if (bitmaps.empty() || !id) {
+    primary_seat_->SetCursorBitmap(NULL);
+    return;
+  }
+
+  primary_seat_->SetCursorBitmap(cursor_cache_->Add(
+      id, bitmaps, location,
+      base::TimeDelta::FromMilliseconds(frame_delay_ms)));
+}
+
+void WaylandDisplay::ShowCursor(uint64_t id) {
+  const WaylandCursorCache::Entry* cursor = cursor_cache_->Get(id);
+  if (!cursor)
+    LOG(ERROR) << "Received unknown cursor " << id << " from the browser";
+
+  primary_seat_->SetCursorBitmap(cursor);
+}
+
+void WaylandDisplay::SetCursorType(int type) {
+  wl_cursor* cursor = cursor_theme_ ? cursor_theme_->GetCursor(type) : NULL;
+  if (!cursor) {
+    LOG(ERROR) << "Received cursor type " << type << " missing in the theme";
+    return;
+  }
+
+  primary_seat_->SetThemeCursor(cursor, cursor_theme_->scale());
 }
 
 void WaylandDisplay::MoveCursor(const gfx::Point& location) {
@@ -558,6 +1032,26 @@ void WaylandDisplay::DrmHandleDevice(const char* device) {
 void WaylandDisplay::SetWLDrmFormat(uint32_t) {
 }
 
+wl_buffer* WaylandDisplay::CreatePrimeBuffer(int fd,
+                                             const gfx::Size& size,
+                                             uint32_t format,
+                                             int stride) {
+  if (!m_drm || !(m_capabilities_ & WL_DRM_CAPABILITY_PRIME))
+    return NULL;
+
+  return wl_drm_create_prime_buffer(m_drm,
+                                    fd,
+                                    size.width(),
+                                    size.height(),
+                                    format,
+                                    0,
+                                    stride,
+                                    0,
+                                    0,
+                                    0,
+                                    0);
+}
+
 void WaylandDisplay::DrmAuthenticated() {
   m_authenticated_ = true;
   device_ = gbm_create_device(m_fd_);
@@ -582,8 +1076,14 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
   WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
 
   if (strcmp(interface, "wl_compositor") == 0) {
-    disp->compositor_ = static_cast<wl_compositor*>(
-        wl_registry_bind(registry, name, &wl_compositor_interface, 1));
+    // Version 3 adds the buffer scale, used by the theme cursors, version 4
+    // the buffer damage used by partial swaps.
+    disp->compositor_ = static_cast<wl_compositor*>(wl_registry_bind(
+        registry, name, &wl_compositor_interface,
+        std::min<uint32_t>(version, WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION)));
+  } else if (strcmp(interface, "wl_subcompositor") == 0) {
+    disp->subcompositor_ = static_cast<wl_subcompositor*>(
+        wl_registry_bind(registry, name, &wl_subcompositor_interface, 1));
   } else if (strcmp(interface, "wl_data_device_manager") == 0) {
     disp->data_device_manager_ = static_cast<wl_data_device_manager*>(
         wl_registry_bind(registry, name, &wl_data_device_manager_interface, 1));
@@ -596,7 +1096,7 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
     wl_drm_add_listener(m_drm, &drm_listener, disp);
 #endif
   } else if (strcmp(interface, "wl_output") == 0) {
-    WaylandScreen* screen = new WaylandScreen(disp->registry(), name);
+    WaylandScreen* screen = new WaylandScreen(disp->registry(), name, version);
     if (!disp->screen_list_.empty())
       NOTIMPLEMENTED() << "Multiple screens support is not implemented";
 
@@ -614,33 +1114,98 @@ void WaylandDisplay::DisplayHandleGlobal(void *data,
   } else if (strcmp(interface, "wl_shm") == 0) {
     disp->shm_ = static_cast<wl_shm*>(
         wl_registry_bind(registry, name, &wl_shm_interface, 1));
+  } else if (strcmp(interface, "wp_presentation") == 0) {
+    static const struct wp_presentation_listener presentation_listener = {
+      WaylandDisplay::PresentationClockId
+    };
+
+    disp->presentation_ = static_cast<wp_presentation*>(
+        wl_registry_bind(registry, name, &wp_presentation_interface, 1));
+    wp_presentation_add_listener(disp->presentation_,
+                                 &presentation_listener,
+                                 disp);
+  } else if (strcmp(interface, "wp_viewporter") == 0) {
+    disp->viewporter_ = static_cast<wp_viewporter*>(
+        wl_registry_bind(registry, name, &wp_viewporter_interface, 1));
   } else if (strcmp(interface, "wl_text_input_manager") == 0) {
-    disp->text_input_manager_ = static_cast<wl_text_input_manager*>(
-        wl_registry_bind(registry, name, &wl_text_input_manager_interface, 1));
+    // Bound lazily by GetTextInputManager.
+    disp->text_input_manager_name_ = name;
   } else {
     disp->shell_->Initialize(registry, name, interface, version);
   }
 }
 
+void WaylandDisplay::GlobalsSyncDone(void* data,
+                                     struct wl_callback* callback,
+                                     uint32_t time) {
+  WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
+  wl_callback_destroy(callback);
+  // The globals bound so far send their initial state, e.g. the output scale,
+  // in reply to the bind. One more round trip to have it.
+  static const struct wl_callback_listener globals_state_listener = {
+    WaylandDisplay::GlobalsStateDone
+  };
+
+  disp->globals_sync_ = wl_display_sync(disp->display_);
+  wl_callback_add_listener(disp->globals_sync_, &globals_state_listener, disp);
+}
+
+// static
+void WaylandDisplay::GlobalsStateDone(void* data,
+                                      struct wl_callback* callback,
+                                      uint32_t time) {
+  WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
+  wl_callback_destroy(callback);
+  disp->globals_sync_ = NULL;
+  TRACE_EVENT_ASYNC_END0("ozone", "WaylandDisplay::BindGlobals", disp);
+  disp->globals_ready_.Signal();
+}
+
+// static
+void WaylandDisplay::PresentationClockId(void* data,
+                                         wp_presentation* presentation,
+                                         uint32_t clock_id) {
+  WaylandDisplay* disp = static_cast<WaylandDisplay*>(data);
+  disp->presentation_clock_id_ = clock_id;
+}
+
 void WaylandDisplay::OnChannelEstablished(IPC::Sender* sender) {
-  loop_ = base::MessageLoop::current();
   sender_ = sender;
-  while (!deferred_messages_.empty()) {
-    Dispatch(deferred_messages_.front());
-    deferred_messages_.pop();
+  {
+    // The deferred messages go first, other threads wait for them to be
+    // queued before queueing their own.
+    base::AutoLock lock(deferred_messages_lock_);
+    loop_ = base::MessageLoop::current();
+    loop_->AddTaskObserver(this);
+    while (!deferred_messages_.empty()) {
+      QueueMessage(deferred_messages_.front());
+      deferred_messages_.pop();
+    }
   }
+
+  // The browser shows the cursors of the theme by their type.
+  if (WaitForGlobals() && cursor_theme_)
+    Dispatch(new WaylandInput_CursorTheme(cursor_theme_->GetSupportedTypes()));
 }
 
 bool WaylandDisplay::OnMessageReceived(const IPC::Message& message) {
+  if (!WaitForGlobals())
+    return false;
+
   bool handled = true;
   IPC_BEGIN_MESSAGE_MAP(WaylandDisplay, message)
   IPC_MESSAGE_HANDLER(WaylandDisplay_State, SetWidgetState)
   IPC_MESSAGE_HANDLER(WaylandDisplay_Create, CreateWidget)
   IPC_MESSAGE_HANDLER(WaylandDisplay_MoveWindow, MoveWindow)
   IPC_MESSAGE_HANDLER(WaylandDisplay_Title, SetWidgetTitle)
-  IPC_MESSAGE_HANDLER(WaylandDisplay_AddRegion, AddRegion)
-  IPC_MESSAGE_HANDLER(WaylandDisplay_SubRegion, SubRegion)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_SetRegion, SetRegion)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_RenderScale, SetRenderScale)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CanvasMemory, SetCanvasMemory)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_PresentCanvas, PresentCanvas)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_DestroyCanvas, DestroyCanvas)
   IPC_MESSAGE_HANDLER(WaylandDisplay_CursorSet, SetCursorBitmap)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorShow, ShowCursor)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_CursorSetType, SetCursorType)
   IPC_MESSAGE_HANDLER(WaylandDisplay_MoveCursor, MoveCursor)
   IPC_MESSAGE_HANDLER(WaylandDisplay_ImeReset, ResetIme)
   IPC_MESSAGE_HANDLER(WaylandDisplay_ShowInputPanel, ShowInputPanel)
@@ -649,6 +1214,7 @@ bool WaylandDisplay::OnMessageReceived(const IPC::Message& message) {
   IPC_MESSAGE_HANDLER(WaylandDisplay_RequestSelectionData, RequestSelectionData)
   IPC_MESSAGE_HANDLER(WaylandDisplay_DragWillBeAccepted, DragWillBeAccepted)
   IPC_MESSAGE_HANDLER(WaylandDisplay_DragWillBeRejected, DragWillBeRejected)
+  IPC_MESSAGE_HANDLER(WaylandDisplay_InputRing, SetInputRing)
   IPC_MESSAGE_UNHANDLED(handled = false)
   IPC_END_MESSAGE_MAP()
 
@@ -659,8 +1225,16 @@ IPC::MessageFilter* WaylandDisplay::GetMessageFilter() {
   return NULL;
 }
 
-void WaylandDisplay::MotionNotify(float x, float y, int device_id) {
-  Dispatch(new WaylandInput_MotionNotify(ui::PointerPosition(x, y), device_id));
+void WaylandDisplay::MotionNotify(float x,
+                                  float y,
+                                  uint32_t time_stamp,
+                                  int device_id) {
+  ui::InputEventRecord event;
+  event.kind = ui::INPUT_MOTION;
+  event.position = ui::PointerPosition(x, y);
+  event.time_stamp = time_stamp;
+  event.device_id = device_id;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::ButtonNotify(unsigned handle,
@@ -669,7 +1243,16 @@ void WaylandDisplay::ButtonNotify(unsigned handle,
                                   float x,
                                   float y,
                                   int device_id) {
-  Dispatch(new WaylandInput_ButtonNotify(handle, type, flags, ui::PointerPosition(x, y), device_id));
+  ui::InputEventRecord event;
+  event.kind = ui::INPUT_BUTTON;
+  event.handle = handle;
+  event.type = type;
+  event.flags = flags;
+  event.position = ui::PointerPosition(x, y);
+  event.device_id = device_id;
+  QueueInputEvent(event);
+  // Don't delay clicks behind the coalesced motion.
+  FlushInputEvents();
 }
 
 void WaylandDisplay::AxisNotify(float x,
@@ -677,35 +1260,49 @@ void WaylandDisplay::AxisNotify(float x,
                                 int xoffset,
                                 int yoffset,
                                 int device_id) {
-  Dispatch(new WaylandInput_AxisNotify(ui::PointerPosition(x, y), xoffset, yoffset, device_id));
+  ui::InputEventRecord event;
+  event.kind = ui::INPUT_AXIS;
+  event.position = ui::PointerPosition(x, y);
+  event.x_offset = xoffset;
+  event.y_offset = yoffset;
+  event.device_id = device_id;
+  QueueInputEvent(event);
 }
 
 void WaylandDisplay::PointerEnter(unsigned handle, float x, float y) {
-  Dispatch(new WaylandInput_PointerEnter(handle, x, y));
+  FlushInputEvents();
+  Dispatch(new WaylandInput_PointerEnter(handle, x, y, NextInputSequence()));
 }
 
 void WaylandDisplay::PointerLeave(unsigned handle, float x, float y) {
-  Dispatch(new WaylandInput_PointerLeave(handle, x, y));
+  FlushInputEvents();
+  Dispatch(new WaylandInput_PointerLeave(handle, x, y, NextInputSequence()));
 }
 
 void WaylandDisplay::KeyboardEnter(unsigned handle) {
-  Dispatch(new WaylandInput_KeyboardEnter(handle));
+  FlushInputEvents();
+  Dispatch(new WaylandInput_KeyboardEnter(handle, NextInputSequence()));
 }
 
 void WaylandDisplay::KeyboardLeave(unsigned handle) {
-  Dispatch(new WaylandInput_KeyboardLeave(handle));
+  FlushInputEvents();
+  Dispatch(new WaylandInput_KeyboardLeave(handle, NextInputSequence()));
 }
 
 void WaylandDisplay::KeyNotify(ui::EventType type,
                                unsigned code,
                                int device_id) {
-  Dispatch(new WaylandInput_KeyNotify(type, code, device_id));
+  FlushInputEvents();
+  Dispatch(new WaylandInput_KeyNotify(type, code, device_id,
+                                      NextInputSequence()));
 }
 
 void WaylandDisplay::VirtualKeyNotify(ui::EventType type,
                                       uint32_t key,
                                       int device_id) {
-  Dispatch(new WaylandInput_VirtualKeyNotify(type, key, device_id));
+  FlushInputEvents();
+  Dispatch(new WaylandInput_VirtualKeyNotify(type, key, device_id,
+                                             NextInputSequence()));
 }
 
 void WaylandDisplay::TouchNotify(ui::EventType type,
@@ -714,7 +1311,30 @@ void WaylandDisplay::TouchNotify(ui::EventType type,
                                  int32_t touch_id,
                                  uint32_t time_stamp,
                                  int device_id) {
-  Dispatch(new WaylandInput_TouchNotify(type, ui::PointerPosition(x, y), touch_id, time_stamp, device_id));
+  ui::InputEventRecord event;
+  event.kind = ui::INPUT_TOUCH;
+  event.type = type;
+  event.position = ui::PointerPosition(x, y);
+  event.touch_id = touch_id;
+  event.time_stamp = time_stamp;
+  event.device_id = device_id;
+  QueueInputEvent(event);
+}
+
+void WaylandDisplay::FlushInputEvents() {
+  std::vector<ui::InputEventRecord> events;
+  {
+    base::AutoLock lock(input_events_lock_);
+    if (!input_events_->HasPendingEvents())
+      return;
+
+    input_events_->TakeEvents(&events);
+  }
+
+  // Batches go through the message queue like the other input messages, so
+  // that the browser receives them in order. DrainMessageQueue writes them to
+  // the input ring instead if there is one.
+  Dispatch(new WaylandInput_EventBatch(events, NextInputSequence()));
 }
 
 void WaylandDisplay::OutputSizeChanged(unsigned width, unsigned height) {
@@ -727,6 +1347,10 @@ void WaylandDisplay::WindowResized(unsigned handle,
   Dispatch(new WaylandWindow_Resized(handle, width, height));
 }
 
+void WaylandDisplay::RenderScaleRequested(unsigned handle, float scale) {
+  Dispatch(new WaylandWindow_RenderScale(handle, scale));
+}
+
 void WaylandDisplay::WindowUnminimized(unsigned handle) {
   Dispatch(new WaylandWindow_Unminimized(handle));
 }
@@ -805,15 +1429,102 @@ void WaylandDisplay::SeatAssignmentChanged(const std::string seat_name,
 }
 
 void WaylandDisplay::Dispatch(IPC::Message* message) {
-  if (!loop_) {
-    deferred_messages_.push(message);
-    return;
+  {
+    base::AutoLock lock(deferred_messages_lock_);
+    if (!loop_) {
+      deferred_messages_.push(message);
+      return;
+    }
+  }
+
+  QueueMessage(message);
+}
+
+void WaylandDisplay::QueueMessage(IPC::Message* message) {
+  while (!message_queue_->Push(message)) {
+    // The queue is full. The main loop can make room itself, other threads
+    // need to wait for it.
+    if (base::MessageLoop::current() == loop_)
+      DrainMessageQueue();
+    else
+      base::PlatformThread::YieldCurrentThread();
   }
 
+  // Only post one task for all the messages queued until it runs.
+  base::subtle::MemoryBarrier();
+  if (base::subtle::NoBarrier_CompareAndSwap(&message_drain_pending_, 0, 1))
+    return;
+
   loop_->task_runner()->PostTask(FROM_HERE,
-      base::Bind(&WaylandDisplay::Send,
-                 weak_ptr_factory_.GetWeakPtr(),
-                 message));
+      base::Bind(&WaylandDisplay::DrainMessageQueue,
+                 weak_ptr_factory_.GetWeakPtr()));
+}
+
+void WaylandDisplay::DrainMessageQueue() {
+  base::subtle::NoBarrier_Store(&message_drain_pending_, 0);
+  base::subtle::MemoryBarrier();
+
+  size_t depth = message_queue_->Size();
+  message_queue_high_watermark_ =
+      std::max(message_queue_high_watermark_, depth);
+  TRACE_COUNTER2("ozone", "WaylandDisplay::MessageQueue",
+                 "depth", depth,
+                 "high_watermark", message_queue_high_watermark_);
+
+  IPC::Message* message;
+  while (message_queue_->Pop(&message)) {
+    if (message->type() != WaylandInput_EventBatch::ID ||
+        !input_ring_.IsAttached()) {
+      Send(message);
+      continue;
+    }
+
+    WaylandInput_EventBatch::Param param;
+    if (WaylandInput_EventBatch::Read(message, &param))
+      SendInputEvents(std::get<0>(param), std::get<1>(param));
+
+    delete message;
+  }
+}
+
+void WaylandDisplay::SendInputEvents(
+    const std::vector<ui::InputEventRecord>& events,
+    uint32_t sequence) {
+  if (input_ring_.Push(events, sequence)) {
+    uint64_t value = 1;
+    HANDLE_EINTR(write(input_ring_fd_, &value, sizeof(value)));
+    return;
+  }
+
+  // The ring is full, send the batch the usual way. It isn't split, so that
+  // its sequence number is either in the ring or in a message.
+  Send(new WaylandInput_EventBatch(events, sequence));
+}
+
+void WaylandDisplay::SetInputRing(base::SharedMemoryHandle handle,
+                                  uint32_t size,
+                                  base::FileDescriptor eventfd) {
+  ResetInputRing();
+  std::unique_ptr<base::SharedMemory> memory(
+      new base::SharedMemory(handle, false));
+  if (!memory->Map(size) ||
+      !input_ring_.Attach(memory->memory(), size, false)) {
+    LOG(ERROR) << "Failed to map the input event ring.";
+    close(eventfd.fd);
+    return;
+  }
+
+  input_ring_memory_ = std::move(memory);
+  input_ring_fd_ = eventfd.fd;
+}
+
+void WaylandDisplay::ResetInputRing() {
+  input_ring_.Detach();
+  input_ring_memory_.reset();
+  if (input_ring_fd_ >= 0) {
+    close(input_ring_fd_);
+    input_ring_fd_ = -1;
+  }
 }
 
 void WaylandDisplay::Send(IPC::Message* message) {
@@ -824,5 +1535,10 @@ void WaylandDisplay::Send(IPC::Message* message) {
   sender_->Send(message);
 }
 
+uint32_t WaylandDisplay::NextInputSequence() {
+  return static_cast<uint32_t>(
+      base::subtle::NoBarrier_AtomicIncrement(&input_sequence_, 1));
+}
+
 }  // namespace ozonewayland
 
@@ -19,13 +19,22 @@
 #include <wayland-client.h>
 #include <list>
 #include <map>
+#include <memory>
 #include <queue>
+#include <set>
 #include <string>
 #include <vector>
 
+#include "base/atomicops.h"
 #include "base/macros.h"
 #include "base/memory/shared_memory.h"
 #include "base/memory/weak_ptr.h"
+#include "base/message_loop/message_loop.h"
+#include "base/synchronization/condition_variable.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/time/time.h"
+#include "ozone/platform/input_event_ring.h"
 #include "ozone/platform/window_constants.h"
 #include "ui/events/event_constants.h"
 #include "ui/ozone/public/gpu_platform_support.h"
@@ -34,9 +43,11 @@
 struct gbm_device;
 struct wl_egl_window;
 struct wl_text_input_manager;
+struct wp_presentation;
+struct wp_viewporter;
 
 namespace base {
-class MessageLoop;
+class Thread;
 }
 
 namespace IPC {
@@ -45,10 +56,16 @@ class Sender;
 
 namespace ozonewayland {
 
+class SurfaceOzoneCanvasWayland;
+class WaylandCursorCache;
+class WaylandCursorTheme;
 class WaylandDisplayPollThread;
+class WaylandEventCoalescer;
+template <typename T> class LockFreeQueue;
 class WaylandScreen;
 class WaylandSeat;
 class WaylandShell;
+class WaylandShmArena;
 class WaylandWindow;
 
 typedef std::map<unsigned, WaylandWindow*> WindowMap;
@@ -57,7 +74,8 @@ typedef std::map<unsigned, WaylandWindow*> WindowMap;
 // wl_display, the Wayland server will send different events to register
 // the Wayland compositor, shell, screens, input devices, ...
 class WaylandDisplay : public ui::SurfaceFactoryOzone,
-                       public ui::GpuPlatformSupport {
+                       public ui::GpuPlatformSupport,
+                       public base::MessageLoop::TaskObserver {
  public:
   WaylandDisplay();
   ~WaylandDisplay() override;
@@ -70,6 +88,12 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
 
   wl_registry* registry() const { return registry_; }
 
+  // Returns the queue used by the seat objects (pointer, keyboard, touch and
+  // data device). It is dispatched by the dedicated input thread, so that
+  // input latency doesn't depend on the load of the GPU main thread or on the
+  // background display thread.
+  wl_event_queue* GetInputQueue() const { return input_queue_; }
+
   // Warning: Most uses of this function need to be removed in order to fix
   // multiseat. See: https://github.com/01org/ozone-wayland/issues/386
   WaylandSeat* PrimarySeat() const { return primary_seat_; }
@@ -81,8 +105,19 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   WaylandShell* GetShell() const { return shell_; }
 
   wl_shm* GetShm() const { return shm_; }
+  // Shared memory all the wl_shm buffers are allocated from.
+  WaylandShmArena* GetShmArena() const { return shm_arena_.get(); }
   wl_compositor* GetCompositor() const { return compositor_; }
-  struct wl_text_input_manager* GetTextInputManager() const;
+  wl_subcompositor* GetSubcompositor() const { return subcompositor_; }
+  // Returns NULL if the compositor doesn't support presentation feedback.
+  wp_presentation* GetPresentation() const { return presentation_; }
+  // Returns NULL if the compositor doesn't support surface scaling/cropping.
+  wp_viewporter* GetViewporter() const { return viewporter_; }
+  // Converts a presentation feedback timestamp to TimeTicks.
+  base::TimeTicks PresentationTimeToTimeTicks(uint64_t seconds,
+                                              uint32_t nanoseconds) const;
+  // Binds the text input manager on first use.
+  struct wl_text_input_manager* GetTextInputManager();
 
   wl_data_device_manager*
   GetDataDeviceManager() const { return data_device_manager_; }
@@ -98,11 +133,41 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   // Destroys WaylandWindow whose handle is w.
   void DestroyWindow(unsigned w);
 
-  // Does a round trip to Wayland server. This call blocks the current thread
-  // until all pending request are processed by the server.
+  // Sends the pending requests to the Wayland server right away. Only meant
+  // for latency critical paths, ScheduleFlush should be used otherwise.
   void FlushDisplay();
+  // Marks the connection as having pending requests. When called on the main
+  // loop, they are flushed once at the end of the current task, so that a
+  // burst of requests costs a single flush. Blocking points (roundtrips,
+  // eglSwapBuffers) flush the display by themselves.
+  void ScheduleFlush();
+  // Number of times the input thread found the connection unable to take all
+  // pending requests (see WaylandDisplayPollThread::RequestFlush).
+  int flush_stall_count() const;
+  // Number of times the input thread has read events, see WaitForEventsRead.
+  uint32_t events_read_count();
+  // Blocks until the input thread reads events after it had read them
+  // |count| times, or until |deadline|. Returns false on timeout. This is how
+  // other threads wait for their queues, reading the display themselves would
+  // hold the input thread up until they read too.
+  bool WaitForEventsRead(uint32_t count, base::TimeTicks deadline);
 
   bool InitializeHardware();
+  // Core globals (compositor, shell, seats, outputs) are bound asynchronously
+  // by the display thread. Blocks until that is done and returns false if
+  // the connection has been lost meanwhile. Only needed on the GPU main thread.
+  bool WaitForGlobals();
+  // Called after every swap, ends the WaylandDisplay::TimeToFirstFrame trace
+  // event started in InitializeHardware.
+  void OnFrameSwapped();
+
+  // Number of messages waiting for the main loop to send them, and the
+  // highest number seen so far. Also reported as the
+  // WaylandDisplay::MessageQueue trace counter.
+  size_t message_queue_depth() const;
+  size_t message_queue_high_watermark() const {
+    return message_queue_high_watermark_;
+  }
 
   // Ozone Display implementation:
   intptr_t GetNativeDisplay() override;
@@ -121,8 +186,12 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
 
   std::unique_ptr<ui::SurfaceOzoneCanvas> CreateCanvasForWidget(
       gfx::AcceleratedWidget widget) override;
+  // Software compositing runs in the browser process, which has no Wayland
+  // connection. Canvases created there send their frames to the GPU process
+  // through |sender|.
+  void SetCanvasSender(IPC::Sender* sender) { canvas_sender_ = sender; }
 
-  void MotionNotify(float x, float y, int device_id);
+  void MotionNotify(float x, float y, uint32_t time_stamp, int device_id);
   void ButtonNotify(unsigned handle,
                     ui::EventType type,
                     ui::EventFlags flags,
@@ -142,9 +211,23 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
                    int32_t touch_id,
                    uint32_t time_stamp,
                    int device_id);
+  // Sends the pointer and touch events accumulated so far in a single
+  // WaylandInput_EventBatch message. Called at the end of every wl_touch frame,
+  // when the coalesced motion can go (see OnInputEventsRead), on button events
+  // and before any other input message so that the browser sees the events in
+  // order.
+  void FlushInputEvents();
+  // Count the frames the windows committed and the compositor hasn't
+  // repainted yet. Motion is held back while there are some.
+  void FrameCommitted();
+  void FramesDone(size_t count);
+  // The seats |windowhandle| accepts events from may have changed. May be
+  // called on any thread, the input thread updates the window.
+  void SeatAcceptanceChanged(unsigned windowhandle);
 
   void OutputSizeChanged(unsigned width, unsigned height);
   void WindowResized(unsigned handle, unsigned width, unsigned height);
+  void RenderScaleRequested(unsigned handle, float scale);
   void WindowUnminimized(unsigned windowhandle);
   void WindowDeActivated(unsigned windowhandle);
   void WindowActivated(unsigned windowhandle);
@@ -179,11 +262,19 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
   void SetWLDrmFormat(uint32_t);
   void DrmAuthenticated();
   void SetDrmCapabilities(uint32_t);
+  // Wraps a dma-buf in a wl_buffer the compositor can show directly.
+  wl_buffer* CreatePrimeBuffer(int fd,
+                               const gfx::Size& size,
+                               uint32_t format,
+                               int stride);
 #endif
 
  private:
   typedef std::queue<IPC::Message*> DeferredMessages;
   void InitializeDisplay();
+  // Loads the cursor theme at the largest output scale, once the globals are
+  // bound.
+  void LoadCursorTheme();
   // Creates a WaylandWindow backed by EGL Window and maps it to w. This can be
   // useful for callers to track a particular surface. By default the type of
   // surface(i.e. toplevel, menu) is none. One needs to explicitly call
@@ -193,11 +284,30 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
 
   // Starts polling on display fd. This should be used when one needs to
   // continuously read pending events coming from Wayland compositor and
-  // dispatch them. The polling is done completely on a separate thread and
-  // doesn't block the thread from which this is called.
+  // dispatch them. The input thread is the only one reading the display, it
+  // dispatches the input queue itself and hands the other queues over to
+  // their owners: the display thread for the default queue (outputs, globals,
+  // shell events) and the main loop for the window queues. Doesn't block the
+  // thread from which this is called.
   void StartProcessingEvents();
   // Stops polling on display fd.
   void StopProcessingEvents();
+  // Called on the input thread every time events have been read from the
+  // display. Schedules DispatchWindowQueues on the main loop, unless a
+  // dispatch is already pending.
+  void ScheduleWindowQueuesDispatch();
+  // Same for DispatchDefaultQueue on the display thread.
+  void ScheduleDefaultQueueDispatch();
+  void DispatchDefaultQueue();
+  // Called on the input thread at the end of every dispatch cycle.
+  void OnInputEventsRead();
+  // Returns how long the input thread can wait for new events before the
+  // pending ones need to be flushed.
+  int GetInputPollTimeout();
+  void QueueInputEvent(const ui::InputEventRecord& event);
+  // Dispatches the pending events of every WaylandWindow queue. Runs on the
+  // thread owning the windows.
+  void DispatchWindowQueues();
 
   void Terminate();
   WaylandWindow* GetWidget(unsigned w) const;
@@ -210,10 +320,21 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
                     ui::WidgetType type);
   void MoveWindow(unsigned widget, unsigned parent,
                   ui::WidgetType type, const gfx::Rect& rect);
-  void AddRegion(unsigned widget, int left, int top, int right, int bottom);
-  void SubRegion(unsigned widget, int left, int top, int right, int bottom);
+  void SetRegion(unsigned widget, const std::vector<gfx::Rect>& rects);
+  void SetRenderScale(unsigned widget,
+                      float scale,
+                      const gfx::Size& logical_size);
+  void SetCanvasMemory(unsigned widget,
+                       const gfx::Size& size,
+                       base::SharedMemoryHandle pixels);
+  void PresentCanvas(unsigned widget, const gfx::Rect& damage);
+  void DestroyCanvas(unsigned widget);
   void SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                       const gfx::Point& location);
+                       const gfx::Point& location,
+                       int frame_delay_ms,
+                       uint64_t id);
+  void ShowCursor(uint64_t id);
+  void SetCursorType(int type);
   void MoveCursor(const gfx::Point& location);
   void ResetIme();
   void ImeCaretBoundsChanged(gfx::Rect rect);
@@ -231,38 +352,129 @@ class WaylandDisplay : public ui::SurfaceFactoryOzone,
       uint32_t name,
       const char *interface,
       uint32_t version);
+  static void GlobalsSyncDone(void* data,
+                              struct wl_callback* callback,
+                              uint32_t time);
+  static void GlobalsStateDone(void* data,
+                               struct wl_callback* callback,
+                               uint32_t time);
+  static void PresentationClockId(void* data,
+                                  wp_presentation* presentation,
+                                  uint32_t clock_id);
+
+  // base::MessageLoop::TaskObserver:
+  void WillProcessTask(const base::PendingTask& pending_task) override;
+  void DidProcessTask(const base::PendingTask& pending_task) override;
 
   // GpuPlatformSupport:
   void OnChannelEstablished(IPC::Sender* sender) override;
   bool OnMessageReceived(const IPC::Message& message) override;
   IPC::MessageFilter* GetMessageFilter() override;
-  // Posts task to main loop of the thread on which Dispatcher was initialized.
+  // Queues |message| for the main loop of the thread on which Dispatcher was
+  // initialized. Can be called from any thread.
   void Dispatch(IPC::Message* message);
+  // Hands |message| over to the main loop, once it is known.
+  void QueueMessage(IPC::Message* message);
+  // Sends the messages queued by Dispatch. Runs on the main loop.
+  void DrainMessageQueue();
   void Send(IPC::Message* message);
+  // Returns the sequence number of the next input message or batch. Input is
+  // read on more than one thread.
+  uint32_t NextInputSequence();
+  // Writes |events| to the input ring, falls back to WaylandInput_EventBatch
+  // if they don't fit.
+  void SendInputEvents(const std::vector<ui::InputEventRecord>& events,
+                       uint32_t sequence);
+  void SetInputRing(base::SharedMemoryHandle handle,
+                    uint32_t size,
+                    base::FileDescriptor eventfd);
+  void ResetInputRing();
 
   // WaylandDisplay manages the memory of all these pointers.
   wl_display* display_;
   wl_registry* registry_;
+  wl_event_queue* input_queue_;
   wl_compositor* compositor_;
+  wl_subcompositor* subcompositor_;
   wl_data_device_manager* data_device_manager_;
   WaylandShell* shell_;
   wl_shm* shm_;
+  std::unique_ptr<WaylandShmArena> shm_arena_;
+  // Cursors sent by the browser, uploaded to the arena.
+  std::unique_ptr<WaylandCursorCache> cursor_cache_;
+  // Loaded by InitializeHardware, NULL if it couldn't be.
+  std::unique_ptr<WaylandCursorTheme> cursor_theme_;
+  wp_presentation* presentation_;
+  // Clock domain of the presentation timestamps, a clockid_t.
+  uint32_t presentation_clock_id_;
+  wp_viewporter* viewporter_;
   struct wl_text_input_manager* text_input_manager_;
+  uint32_t text_input_manager_name_;
+  wl_callback* globals_sync_;
+  // Signaled by the display thread once the globals are bound.
+  base::WaitableEvent globals_ready_;
   WaylandScreen* primary_screen_;
   WaylandSeat* primary_seat_;
-  WaylandDisplayPollThread* display_poll_thread_;
+  // Dispatches the default queue at background priority.
+  base::Thread* display_thread_;
+  // Reads all the events, at display priority.
+  WaylandDisplayPollThread* input_poll_thread_;
   gbm_device* device_;
   char* m_deviceName;
   IPC::Sender* sender_;
+  // Browser side, see SetCanvasSender.
+  IPC::Sender* canvas_sender_;
   base::MessageLoop* loop_;
 
   std::list<WaylandScreen*> screen_list_;
   std::list<WaylandSeat*> seat_list_;
   WindowMap widget_map_;
-  // Display queues messages till Channel is establised.
+  // Canvases of the windows the browser composites in software. The entries
+  // stay until the window is DESTROYED, the canvases may be recreated.
+  struct RemoteCanvas;
+  std::map<unsigned, std::unique_ptr<RemoteCanvas>> canvases_;
+  // Display queues messages till Channel is establised. The input and
+  // display threads dispatch messages before that.
   DeferredMessages deferred_messages_;
+  // Guards |deferred_messages_| and the moment |loop_| is set.
+  base::Lock deferred_messages_lock_;
   unsigned serial_;
+  // Set while a DispatchWindowQueues task is posted but hasn't run yet.
+  base::subtle::Atomic32 window_dispatch_pending_;
+  // Set while a DispatchDefaultQueue task is posted but hasn't run yet.
+  base::subtle::Atomic32 default_dispatch_pending_;
+  // See WaitForEventsRead.
+  base::Lock events_read_lock_;
+  base::ConditionVariable events_read_cv_;
+  uint32_t events_read_count_;
+  // Messages handed over from the input and display threads to the main loop.
+  std::unique_ptr<LockFreeQueue<IPC::Message*>> message_queue_;
+  // Set while a DrainMessageQueue task is posted but hasn't run yet.
+  base::subtle::Atomic32 message_drain_pending_;
+  size_t message_queue_high_watermark_;
+  // Pointer and touch events not yet sent to the browser. Mostly accessed from
+  // the input thread, but text input events may come from the display
+  // thread.
+  std::unique_ptr<WaylandEventCoalescer> input_events_;
+  base::Lock input_events_lock_;
+  // See FrameCommitted.
+  base::subtle::Atomic32 frames_in_flight_;
+  // See SeatAcceptanceChanged.
+  std::set<unsigned> seat_acceptance_changes_;
+  base::Lock seat_acceptance_lock_;
+  // Shared memory ring set up by the browser (see WaylandDisplay_InputRing).
+  // Only used on the main loop.
+  std::unique_ptr<base::SharedMemory> input_ring_memory_;
+  ui::InputEventRing input_ring_;
+  int input_ring_fd_;
+  // Last sequence number given to an input message or batch.
+  base::subtle::Atomic32 input_sequence_;
+  // Only accessed on the main loop, FlushDisplay may run on any thread. Not
+  // a bit field, m_authenticated_ is written on the display thread.
+  bool flush_scheduled_;
   bool processing_events_ :1;
+  bool globals_bound_ :1;
+  bool first_frame_swapped_ :1;
   bool m_authenticated_ :1;
   int m_fd_;
   uint32_t m_capabilities_;
@@ -7,101 +7,201 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <wayland-client.h>
 
 #include "base/bind.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/wayland/display.h"
 
 namespace ozonewayland {
 const int MAX_EVENTS = 16;
 
-WaylandDisplayPollThread::WaylandDisplayPollThread(wl_display* display)
-    : base::Thread("WaylandDisplayPollThread"),
+WaylandDisplayPollThread::WaylandDisplayPollThread(
+    const std::string& name,
+    wl_display* display,
+    wl_event_queue* queue,
+    const base::Closure& events_read_callback)
+    : base::Thread(name),
       polling_(base::WaitableEvent::ResetPolicy::MANUAL,
           base::WaitableEvent::InitialState::NOT_SIGNALED),
       stop_polling_(base::WaitableEvent::ResetPolicy::MANUAL,
           base::WaitableEvent::InitialState::NOT_SIGNALED),
-      display_(display) {
+      display_(display),
+      queue_(queue),
+      events_read_callback_(events_read_callback),
+      cpu_affinity_(-1),
+      wakeup_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      flush_stalls_(0) {
   DCHECK(display_);
+  DCHECK_GE(wakeup_fd_, 0);
 }
 
 WaylandDisplayPollThread::~WaylandDisplayPollThread() {
   StopProcessingEvents();
+  if (wakeup_fd_ >= 0)
+    close(wakeup_fd_);
 }
 
-void WaylandDisplayPollThread::StartProcessingEvents() {
+void WaylandDisplayPollThread::StartProcessingEvents(
+    base::ThreadPriority priority) {
   DCHECK(!polling_.IsSignaled());
   base::Thread::Options options;
   options.message_loop_type = base::MessageLoop::TYPE_IO;
-  options.priority = base::ThreadPriority::BACKGROUND;
+  options.priority = priority;
   StartWithOptions(options);
   task_runner()->PostTask(FROM_HERE, base::Bind(
       &WaylandDisplayPollThread::DisplayRun, this));
 }
 
 void WaylandDisplayPollThread::StopProcessingEvents() {
-  if (polling_.IsSignaled())
+  if (polling_.IsSignaled()) {
     stop_polling_.Signal();
+    WakeUp();
+  }
 
   Stop();
 }
 
+void WaylandDisplayPollThread::RequestFlush() {
+  WakeUp();
+}
+
+void WaylandDisplayPollThread::WakeUp() {
+  uint64_t value = 1;
+  HANDLE_EINTR(write(wakeup_fd_, &value, sizeof(value)));
+}
+
 void WaylandDisplayPollThread::CleanUp() {
   SetThreadWasQuitProperly(true);
 }
 
+void WaylandDisplayPollThread::ApplyCpuAffinity() {
+  if (cpu_affinity_ < 0)
+    return;
+
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu_affinity_, &cpu_set);
+  if (sched_setaffinity(0, sizeof(cpu_set), &cpu_set) < 0) {
+    LOG(WARNING) << "Failed to pin " << thread_name() << " to cpu "
+                 << cpu_affinity_ << ": " << errno;
+  }
+}
+
+int WaylandDisplayPollThread::PrepareRead() {
+  if (!queue_)
+    return wl_display_prepare_read(display_);
+
+  return wl_display_prepare_read_queue(display_, queue_);
+}
+
+int WaylandDisplayPollThread::DispatchPending() {
+  if (!queue_)
+    return wl_display_dispatch_pending(display_);
+
+  return wl_display_dispatch_queue_pending(display_, queue_);
+}
+
 void  WaylandDisplayPollThread::DisplayRun(WaylandDisplayPollThread* data) {
-  struct pollfd pollfd;
-  int i, ret, count = 0;
+  struct pollfd pollfds[2];
+  int ret, count = 0;
   uint32_t event = 0;
+  bool stalled = false;
   unsigned display_fd = wl_display_get_fd(data->display_);
-  pollfd.fd = display_fd;
-  pollfd.events = POLLIN | POLLERR | POLLHUP;
+  pollfds[0].fd = display_fd;
+  pollfds[1].fd = data->wakeup_fd_;
+  pollfds[1].events = POLLIN;
+
+  data->ApplyCpuAffinity();
 
   // Set the signal state. This is used to query from other threads (i.e.
   // StopProcessingEvents on Main thread), if this thread is still polling.
   data->polling_.Signal();
 
   // Adopted from:
-  // http://cgit.freedesktop.org/wayland/weston/tree/clients/window.c#n5531.
+  // http://cgit.freedesktop.org/wayland/wayland/tree/src/wayland-client.c
+  // (wl_display_dispatch_queue). We never call wl_display_dispatch here, as
+  // that would also dispatch events meant for queues owned by other threads.
   while (1) {
-    wl_display_dispatch_pending(data->display_);
+    while (data->PrepareRead() != 0)
+      data->DispatchPending();
+
     ret = wl_display_flush(data->display_);
     if (ret < 0 && errno != EAGAIN) {
+      wl_display_cancel_read(data->display_);
       break;
     }
+
+    // The compositor doesn't keep up with our requests. Keep the rest of them
+    // buffered and wait for the socket to be writable again rather than
+    // blocking anyone.
+    if (ret < 0 && !stalled) {
+      stalled = true;
+      base::subtle::NoBarrier_AtomicIncrement(&data->flush_stalls_, 1);
+      TRACE_EVENT_ASYNC_BEGIN0("ozone", "WaylandDisplay::FlushStall", data);
+    } else if (ret >= 0 && stalled) {
+      stalled = false;
+      TRACE_EVENT_ASYNC_END0("ozone", "WaylandDisplay::FlushStall", data);
+    }
+
+    pollfds[0].events = POLLIN | POLLERR | POLLHUP;
+    if (stalled)
+      pollfds[0].events |= POLLOUT;
+
     // StopProcessingEvents has been called or we have been asked to stop
     // polling. Break from the loop.
-    if (data->stop_polling_.IsSignaled())
+    if (data->stop_polling_.IsSignaled()) {
+      wl_display_cancel_read(data->display_);
       break;
+    }
 
-    count = poll(&pollfd, 1, -1);
+    int timeout = data->poll_timeout_callback_.is_null() ?
+        -1 : data->poll_timeout_callback_.Run();
+    count = poll(pollfds, 2, timeout);
     if (count < 0 && errno != EINTR) {
+      wl_display_cancel_read(data->display_);
       LOG(ERROR) << "poll returned an error." << errno;
       break;
     }
 
-    if (count == 1) {
-      event = pollfd.revents;
-      // We can have cases where POLLIN and POLLHUP are both set for
-      // example. Don't break if both flags are set.
-      if ((event & POLLERR || event & POLLHUP) &&
-             !(event & POLLIN)) {
-        break;
-      }
+    if (count > 0 && (pollfds[1].revents & POLLIN)) {
+      uint64_t value;
+      HANDLE_EINTR(read(data->wakeup_fd_, &value, sizeof(value)));
+    }
+
+    event = count > 0 ? pollfds[0].revents : 0;
+    // We can have cases where POLLIN and POLLHUP are both set for
+    // example. Don't break if both flags are set.
+    if ((event & POLLERR || event & POLLHUP) && !(event & POLLIN)) {
+      wl_display_cancel_read(data->display_);
+      break;
+    }
 
-      if (event & POLLIN) {
-        ret = wl_display_dispatch(data->display_);
-        if (ret == -1) {
-          LOG(ERROR) << "wl_display_dispatch failed with an error." << errno;
-          break;
-        }
+    if (event & POLLIN) {
+      ret = wl_display_read_events(data->display_);
+      if (ret == -1) {
+        LOG(ERROR) << "wl_display_read_events failed with an error." << errno;
+        break;
       }
+    } else {
+      wl_display_cancel_read(data->display_);
     }
+
+    data->DispatchPending();
+
+    if (!data->events_read_callback_.is_null())
+      data->events_read_callback_.Run();
   }
 
+  if (stalled)
+    TRACE_EVENT_ASYNC_END0("ozone", "WaylandDisplay::FlushStall", data);
+
   data->polling_.Reset();
   data->stop_polling_.Reset();
 }
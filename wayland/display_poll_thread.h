@@ -5,34 +5,83 @@
 #ifndef OZONE_WAYLAND_DISPLAY_POLL_THREAD_H_
 #define OZONE_WAYLAND_DISPLAY_POLL_THREAD_H_
 
+#include "base/atomicops.h"
+#include "base/callback.h"
 #include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
 #include "base/threading/thread.h"
 
 struct wl_display;
+struct wl_event_queue;
 namespace ozonewayland {
 // This class lets you poll on a given Wayland display (passed in constructor),
-// read any pending events coming from Wayland compositor and dispatch them.
+// read any pending events coming from Wayland compositor and dispatch the ones
+// sorted into |queue| (the default queue of the display if NULL). Events are
+// read with wl_display_prepare_read_queue/wl_display_read_events, so that they
+// end up in the queue of the proxy they belong to. Several threads could poll
+// the same display that way, but wl_display_read_events waits for all of them,
+// so WaylandDisplay keeps to a single one. |events_read_callback| is run on
+// this thread after every read, so that owners of queues which are not polled
+// (i.e. WaylandWindow queues dispatched on the GPU main thread) can be woken up.
 // Caller should ensure that StopProcessingEvents is called before display is
 // destroyed.
 class WaylandDisplayPollThread : public base::Thread {
  public:
-  explicit WaylandDisplayPollThread(wl_display* display);
+  WaylandDisplayPollThread(const std::string& name,
+                           wl_display* display,
+                           wl_event_queue* queue,
+                           const base::Closure& events_read_callback);
   ~WaylandDisplayPollThread() override;
 
+  // Pins the thread to |cpu| once it starts polling. Needs to be called before
+  // StartProcessingEvents.
+  void SetCpuAffinity(int cpu) { cpu_affinity_ = cpu; }
+  // |callback| returns the maximum time, in milliseconds, the thread may wait
+  // for new events (-1 for no limit). |events_read_callback| is run as well
+  // when that time elapses. Needs to be called before StartProcessingEvents.
+  void SetPollTimeoutCallback(const base::Callback<int()>& callback) {
+    poll_timeout_callback_ = callback;
+  }
+
   // Starts polling on wl_display fd and read/flush requests coming from Wayland
   // compositor.
-  void StartProcessingEvents();
+  void StartProcessingEvents(base::ThreadPriority priority);
   // Stops polling and handling of any events from Wayland compositor.
   void StopProcessingEvents();
+  // Wakes the thread up so that it flushes the display. Used when a flush
+  // from another thread couldn't send all the requests, the thread then keeps
+  // flushing as soon as the socket is writable again. Can be called from any
+  // thread.
+  void RequestFlush();
+  // Interrupts the wait for events, so that |events_read_callback| runs. Can
+  // be called from any thread.
+  void WakeUp();
+  // Number of times a flush couldn't send all the pending requests because
+  // the socket buffer was full.
+  int flush_stalls() const {
+    return base::subtle::NoBarrier_Load(&flush_stalls_);
+  }
 
  protected:
   void CleanUp() override;
 
  private:
   static void DisplayRun(WaylandDisplayPollThread* data);
+  void ApplyCpuAffinity();
+  // Helpers hiding the differences between the default queue and the others.
+  int PrepareRead();
+  int DispatchPending();
+
   base::WaitableEvent polling_;  // Is set as long as the thread is polling.
   base::WaitableEvent stop_polling_;
   wl_display* display_;
+  wl_event_queue* queue_;
+  base::Closure events_read_callback_;
+  base::Callback<int()> poll_timeout_callback_;
+  int cpu_affinity_;
+  // Written to interrupt poll (see WakeUp).
+  int wakeup_fd_;
+  base::subtle::Atomic32 flush_stalls_;
   DISALLOW_COPY_AND_ASSIGN(WaylandDisplayPollThread);
 };
 
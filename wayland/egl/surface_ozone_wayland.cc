@@ -4,20 +4,65 @@
 
 #include "ozone/wayland/egl/surface_ozone_wayland.h"
 
+#include <string.h>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/wayland/display.h"
+#include "ozone/wayland/egl/vsync_provider_wayland.h"
+#include "ozone/wayland/shell/shell_surface.h"
 #include "ozone/wayland/window.h"
 #include "third_party/khronos/EGL/egl.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/swap_result.h"
 #include "ui/gfx/vsync_provider.h"
 
 namespace ozonewayland {
 
+namespace {
+
+typedef EGLBoolean (*SwapBuffersWithDamageProc)(EGLDisplay display,
+                                                EGLSurface surface,
+                                                EGLint* rects,
+                                                EGLint n_rects);
+
+// Without damage, Mesa damages the whole surface on every swap.
+SwapBuffersWithDamageProc GetSwapBuffersWithDamage() {
+  static bool initialized = false;
+  static SwapBuffersWithDamageProc swap_with_damage = NULL;
+  if (initialized)
+    return swap_with_damage;
+
+  EGLDisplay display = eglGetCurrentDisplay();
+  if (display == EGL_NO_DISPLAY)
+    return NULL;
+
+  initialized = true;
+  const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (!extensions)
+    return NULL;
+
+  if (strstr(extensions, "EGL_KHR_swap_buffers_with_damage")) {
+    swap_with_damage = reinterpret_cast<SwapBuffersWithDamageProc>(
+        eglGetProcAddress("eglSwapBuffersWithDamageKHR"));
+  } else if (strstr(extensions, "EGL_EXT_swap_buffers_with_damage")) {
+    swap_with_damage = reinterpret_cast<SwapBuffersWithDamageProc>(
+        eglGetProcAddress("eglSwapBuffersWithDamageEXT"));
+  }
+
+  return swap_with_damage;
+}
+
+}  // namespace
+
 SurfaceOzoneWayland::SurfaceOzoneWayland(unsigned handle)
     : handle_(handle) {
 }
 
 SurfaceOzoneWayland::~SurfaceOzoneWayland() {
   WaylandDisplay::GetInstance()->DestroyWindow(handle_);
-  WaylandDisplay::GetInstance()->FlushDisplay();
+  WaylandDisplay::GetInstance()->ScheduleFlush();
 }
 
 intptr_t SurfaceOzoneWayland::GetNativeWindow() {
@@ -33,19 +78,84 @@ bool SurfaceOzoneWayland::ResizeNativeWindow(
 }
 
 bool SurfaceOzoneWayland::OnSwapBuffers() {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (window) {
+    window->CommitOverlays();
+    window->DidCommitFrame(base::Closure());
+    window->ThrottleFrames();
+  }
+
+  display->OnFrameSwapped();
   return true;
 }
 
 void SurfaceOzoneWayland::OnSwapBuffersAsync(
     const ui::SwapCompletionCallback& callback) {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (!window) {
+    callback.Run(gfx::SwapResult::SWAP_FAILED);
+    return;
+  }
+
+  // The swap is acknowledged once the compositor has repainted with the
+  // buffer, rather than as soon as it is queued, which keeps the scheduler
+  // from getting ahead of the screen without blocking the GPU thread. With
+  // a non-zero interval Mesa waits for the frame callback of the previous
+  // swap in eglSwapBuffers. Chromium may reset the interval when it makes
+  // the context current, hence it is set on every swap.
+  eglSwapInterval(eglGetCurrentDisplay(), 0);
+  window->CommitOverlays();
+  window->DidCommitFrame(base::Bind(callback, gfx::SwapResult::SWAP_ACK));
+  display->OnFrameSwapped();
 }
 
 std::unique_ptr<gfx::VSyncProvider> SurfaceOzoneWayland::CreateVSyncProvider() {
-  return std::unique_ptr<gfx::VSyncProvider>();
+  return std::unique_ptr<gfx::VSyncProvider>(
+      new WaylandVSyncProvider(handle_));
 }
 
 void* SurfaceOzoneWayland::GetEGLSurfaceConfig(const ui::EglConfigCallbacks& egl) {
   return nullptr;
 }
 
+bool SurfaceOzoneWayland::SupportsSwapBuffersWithDamage() {
+  wl_compositor* compositor = WaylandDisplay::GetInstance()->GetCompositor();
+  return GetSwapBuffersWithDamage() &&
+      wl_proxy_get_version(reinterpret_cast<wl_proxy*>(compositor)) >=
+          WL_SURFACE_DAMAGE_BUFFER_SINCE_VERSION;
+}
+
+bool SurfaceOzoneWayland::SwapBuffersWithDamage(const gfx::Rect& damage) {
+  WaylandWindow* window = WaylandDisplay::GetInstance()->GetWindow(handle_);
+  SwapBuffersWithDamageProc swap_with_damage = GetSwapBuffersWithDamage();
+  if (!window || !window->ShellSurface() || !swap_with_damage)
+    return false;
+
+  TRACE_EVENT2("ozone", "SurfaceOzoneWayland::SwapBuffersWithDamage",
+               "width", damage.width(), "height", damage.height());
+  EGLDisplay display = eglGetCurrentDisplay();
+  EGLSurface surface = eglGetCurrentSurface(EGL_DRAW);
+  EGLint height = 0;
+  eglQuerySurface(display, surface, EGL_HEIGHT, &height);
+
+  // |damage| has its origin at the bottom left, the buffer at the top left.
+  // Buffer damage stays exact when the window is rendered at another scale
+  // and cropped with wp_viewporter. Depending on its version, Mesa adds the
+  // rectangle of the swap as surface damage, which may only grow it.
+  wl_surface_damage_buffer(window->ShellSurface()->GetWLSurface(),
+                           damage.x(),
+                           height - damage.bottom(),
+                           damage.width(),
+                           damage.height());
+  EGLint rect[] = { damage.x(), damage.y(), damage.width(), damage.height() };
+  if (!swap_with_damage(display, surface, rect, 1)) {
+    LOG(ERROR) << "eglSwapBuffersWithDamage failed: " << eglGetError();
+    return false;
+  }
+
+  return true;
+}
+
 }  // namespace ozonewayland
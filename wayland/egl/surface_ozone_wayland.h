@@ -24,6 +24,8 @@ class SurfaceOzoneWayland : public ui::SurfaceOzoneEGL {
   void OnSwapBuffersAsync(const ui::SwapCompletionCallback& callback) override;
   std::unique_ptr<gfx::VSyncProvider> CreateVSyncProvider() override;
   void* GetEGLSurfaceConfig(const ui::EglConfigCallbacks& egl) override;
+  bool SupportsSwapBuffersWithDamage() override;
+  bool SwapBuffersWithDamage(const gfx::Rect& damage) override;
 
  private:
   unsigned handle_;
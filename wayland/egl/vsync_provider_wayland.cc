@@ -0,0 +1,42 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/egl/vsync_provider_wayland.h"
+
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/window.h"
+
+namespace ozonewayland {
+
+WaylandVSyncProvider::WaylandVSyncProvider(unsigned handle)
+    : handle_(handle) {
+}
+
+WaylandVSyncProvider::~WaylandVSyncProvider() {
+}
+
+void WaylandVSyncProvider::GetVSyncParameters(
+    const UpdateVSyncCallback& callback) {
+  WaylandWindow* window = WaylandDisplay::GetInstance()->GetWindow(handle_);
+  if (!window)
+    return;
+
+  // Until the compositor has repainted the window once, the scheduler keeps
+  // using its own estimate.
+  base::TimeTicks timebase = window->last_frame_time();
+  if (timebase.is_null())
+    return;
+
+  // Hand out the most recent vblank so that the scheduler can start the next
+  // frame just in time for the following repaint, rather than from a timebase
+  // that drifts further away every frame.
+  base::TimeDelta interval = window->GetRefreshInterval();
+  base::TimeTicks now = base::TimeTicks::Now();
+  if (now > timebase)
+    timebase += ((now - timebase) / interval) * interval;
+
+  callback.Run(timebase, interval);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,31 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_EGL_VSYNC_PROVIDER_WAYLAND_H_
+#define OZONE_WAYLAND_EGL_VSYNC_PROVIDER_WAYLAND_H_
+
+#include "base/macros.h"
+#include "ui/gfx/vsync_provider.h"
+
+namespace ozonewayland {
+
+// Reports the vsync timebase of a window from its wl_surface.frame callbacks
+// and the interval from the refresh rate of the output it is shown on.
+class WaylandVSyncProvider : public gfx::VSyncProvider {
+ public:
+  explicit WaylandVSyncProvider(unsigned handle);
+  ~WaylandVSyncProvider() override;
+
+  // gfx::VSyncProvider:
+  void GetVSyncParameters(const UpdateVSyncCallback& callback) override;
+
+ private:
+  // The window is looked up on each call, as it can be destroyed before us.
+  unsigned handle_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandVSyncProvider);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_EGL_VSYNC_PROVIDER_WAYLAND_H_
@@ -5,8 +5,11 @@
 #include "ozone/wayland/egl/wayland_pixmap.h"
 
 #include <gbm.h>
+#include <wayland-client.h>
 
 #include "base/logging.h"
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/window.h"
 
 namespace ozonewayland {
 
@@ -27,13 +30,14 @@ int GetGbmFormatFromBufferFormat(ui::SurfaceFactoryOzone::BufferFormat fmt) {
 }  // namespace
 
 WaylandPixmap::WaylandPixmap()
-    : bo_(NULL), dma_buf_(-1)  {
+    : bo_(NULL), dma_buf_(-1), buffer_(NULL)  {
 }
 
 bool WaylandPixmap::Initialize(gbm_device* device,
                                ui::SurfaceFactoryOzone::BufferFormat format,
                                const gfx::Size& size) {
   unsigned flags = GBM_BO_USE_RENDERING;
+  size_ = size;
   bo_ = gbm_bo_create(device,
                       size.width(),
                       size.height(),
@@ -54,6 +58,9 @@ bool WaylandPixmap::Initialize(gbm_device* device,
 }
 
 WaylandPixmap::~WaylandPixmap() {
+  if (buffer_)
+    wl_buffer_destroy(buffer_);
+
   if (bo_)
     gbm_bo_destroy(bo_);
 
@@ -73,4 +80,31 @@ int WaylandPixmap::GetDmaBufPitch() {
   return gbm_bo_get_stride(bo_);
 }
 
+bool WaylandPixmap::ScheduleOverlayPlane(gfx::AcceleratedWidget widget,
+                                         int plane_z_order,
+                                         gfx::OverlayTransform plane_transform,
+                                         const gfx::Rect& display_bounds,
+                                         const gfx::RectF& crop_rect) {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(widget);
+  if (!window || plane_transform != gfx::OVERLAY_TRANSFORM_NONE)
+    return false;
+
+  // Subsurfaces show the whole buffer unscaled, see OverlayManagerWayland.
+  if (display_bounds.size() != size_ || crop_rect != gfx::RectF(0, 0, 1, 1))
+    return false;
+
+  if (!buffer_) {
+    buffer_ = display->CreatePrimeBuffer(dma_buf_,
+                                         size_,
+                                         gbm_bo_get_format(bo_),
+                                         GetDmaBufPitch());
+    if (!buffer_)
+      return false;
+  }
+
+  window->ScheduleOverlay(plane_z_order, buffer_, display_bounds.origin());
+  return true;
+}
+
 }  // namespace ozonewayland
@@ -12,6 +12,7 @@
 
 struct gbm_bo;
 struct gbm_device;
+struct wl_buffer;
 
 namespace ozonewayland {
 
@@ -26,12 +27,20 @@ class WaylandPixmap : public ui::NativePixmap {
   void* GetEGLClientBuffer() override;
   int GetDmaBufFd() override;
   int GetDmaBufPitch() override;
+  bool ScheduleOverlayPlane(gfx::AcceleratedWidget widget,
+                            int plane_z_order,
+                            gfx::OverlayTransform plane_transform,
+                            const gfx::Rect& display_bounds,
+                            const gfx::RectF& crop_rect) override;
 
  private:
   ~WaylandPixmap() override;
 
   gbm_bo* bo_;
   int dma_buf_;
+  gfx::Size size_;
+  // Created on the first use as an overlay.
+  wl_buffer* buffer_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandPixmap);
 };
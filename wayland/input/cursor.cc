@@ -4,70 +4,80 @@
 
 #include "ozone/wayland/input/cursor.h"
 
-#include <sys/mman.h>
-#include <vector>
+#include <wayland-cursor.h>
 
 #include "base/logging.h"
-#include "base/memory/shared_memory.h"
 #include "ozone/wayland/display.h"
+#include "ozone/wayland/shm_arena.h"
+#include "ui/gfx/geometry/point.h"
 
 namespace ozonewayland {
 
 WaylandCursor::WaylandCursor() : input_pointer_(NULL),
-    buffer_(NULL),
-    sh_memory_(new base::SharedMemory()),
-    width_(0),
-    height_(0) {
+    buffer_scale_(1),
+    current_frame_(0),
+    frame_callback_(NULL) {
   WaylandDisplay* display = WaylandDisplay::GetInstance();
-  shm_ = display->GetShm();
   pointer_surface_ = wl_compositor_create_surface(display->GetCompositor());
 }
 
 WaylandCursor::~WaylandCursor() {
-  wl_surface_destroy(pointer_surface_);
-  if (buffer_)
-    wl_buffer_destroy(buffer_);
-
-  if (sh_memory_->handle().fd) {
-    sh_memory_->Unmap();
-    sh_memory_->Close();
+  {
+    base::AutoLock lock(lock_);
+    StopAnimation();
   }
-  delete sh_memory_;
+  wl_surface_destroy(pointer_surface_);
 }
 
-void WaylandCursor::UpdateBitmap(const std::vector<SkBitmap>& cursor_image,
-                                 const gfx::Point& location,
+void WaylandCursor::UpdateBitmap(const WaylandCursorCache::Entry* cursor,
                                  uint32_t serial) {
   if (!input_pointer_)
     return;
 
-  if (!cursor_image.size()) {
+  base::AutoLock lock(lock_);
+  StopAnimation();
+  frames_.clear();
+  if (!cursor || cursor->frames.empty()) {
     HideCursor(serial);
     return;
   }
 
-  const SkBitmap& image = cursor_image[0];
-  int width = image.width();
-  int height = image.height();
-  if (!width || !height) {
-    HideCursor(serial);
-    return;
+  for (WaylandShmBuffer* buffer : cursor->frames) {
+    Frame frame = { buffer->buffer(), buffer, buffer->size(), 1,
+                    cursor->frame_delay };
+    frames_.push_back(frame);
   }
 
-  if (!CreateSHMBuffer(width, height)) {
-    LOG(INFO) << "Failed to create SHM buffer for Cursor Bitmap.";
-    wl_pointer_set_cursor(input_pointer_, serial, NULL, 0, 0);
+  ShowCursor(cursor->hotspot, serial);
+}
+
+void WaylandCursor::UpdateThemeCursor(wl_cursor* cursor,
+                                      int scale,
+                                      uint32_t serial) {
+  if (!input_pointer_)
+    return;
+
+  base::AutoLock lock(lock_);
+  StopAnimation();
+  frames_.clear();
+  // Broken themes may have cursors without images.
+  if (!cursor->image_count) {
+    HideCursor(serial);
     return;
   }
 
-  // The |bitmap| contains ARGB image, so just copy it.
-  memcpy(sh_memory_->memory(), image.getPixels(), width_ * height_ * 4);
+  for (unsigned i = 0; i < cursor->image_count; ++i) {
+    wl_cursor_image* image = cursor->images[i];
+    Frame frame = { wl_cursor_image_get_buffer(image), NULL,
+                    gfx::Size(image->width, image->height), scale,
+                    base::TimeDelta::FromMilliseconds(image->delay) };
+    frames_.push_back(frame);
+  }
 
-  wl_pointer_set_cursor(input_pointer_, serial, pointer_surface_,
-                        location.x(), location.y());
-  wl_surface_attach(pointer_surface_, buffer_, 0, 0);
-  wl_surface_damage(pointer_surface_, 0, 0, width_, height_);
-  wl_surface_commit(pointer_surface_);
+  // The images of a theme cursor share the hotspot.
+  wl_cursor_image* image = cursor->images[0];
+  ShowCursor(gfx::Point(image->hotspot_x / scale, image->hotspot_y / scale),
+             serial);
 }
 
 void WaylandCursor::MoveCursor(const gfx::Point& location, uint32_t serial) {
@@ -78,53 +88,90 @@ void WaylandCursor::MoveCursor(const gfx::Point& location, uint32_t serial) {
                          location.x(), location.y());
 }
 
-bool WaylandCursor::CreateSHMBuffer(int width, int height) {
-  if (width == width_ && height == height_)
-    return true;
-
-  struct wl_shm_pool *pool;
-  int size, stride;
+void WaylandCursor::HideCursor(uint32_t serial) {
+  wl_pointer_set_cursor(input_pointer_, serial, NULL, 0, 0);
+}
 
-  width_ = width;
-  height_ = height;
-  stride = width_ * 4;
-  SkImageInfo info = SkImageInfo::MakeN32Premul(width_, height_);
-  size = info.getSafeSize(stride);
+void WaylandCursor::ShowCursor(const gfx::Point& hotspot, uint32_t serial) {
+  lock_.AssertAcquired();
+  current_frame_ = 0;
+  wl_pointer_set_cursor(input_pointer_, serial, pointer_surface_,
+                        hotspot.x(), hotspot.y());
+  ShowFrame();
+}
 
-  if (sh_memory_->handle().fd) {
-    sh_memory_->Unmap();
-    sh_memory_->Close();
+void WaylandCursor::ShowFrame() {
+  lock_.AssertAcquired();
+  // Cached and theme buffers are never written to again, so there is no need
+  // to wait for the compositor to release the one showing.
+  const Frame& frame = frames_[current_frame_];
+  if (frame.shm_buffer) {
+    WaylandDisplay::GetInstance()->GetShmArena()->Attach(frame.shm_buffer,
+                                                         pointer_surface_,
+                                                         0, 0);
+  } else {
+    wl_surface_attach(pointer_surface_, frame.buffer, 0, 0);
   }
 
-  if (!sh_memory_->CreateAndMapAnonymous(size)) {
-    LOG(INFO) << "Create and mmap failed.";
-    return false;
+  // Only ever changed from 1 by theme cursors, which are loaded at scale 1 if
+  // the compositor can't take another one.
+  if (frame.scale != buffer_scale_) {
+    wl_surface_set_buffer_scale(pointer_surface_, frame.scale);
+    buffer_scale_ = frame.scale;
   }
 
-  pool = wl_shm_create_pool(shm_,
-                            sh_memory_->handle().fd,
-                            size);
-  buffer_ = wl_shm_pool_create_buffer(pool, 0,
-                                      width_, height_,
-                                      stride, WL_SHM_FORMAT_ARGB8888);
-  wl_shm_pool_destroy(pool);
-  return true;
+  wl_surface_damage(pointer_surface_, 0, 0,
+                    frame.size.width() / frame.scale,
+                    frame.size.height() / frame.scale);
+  frame_shown_time_ = base::TimeTicks::Now();
+  if (frames_.size() > 1)
+    RequestFrameCallback();
+
+  wl_surface_commit(pointer_surface_);
 }
 
-void WaylandCursor::HideCursor(uint32_t serial) {
-  width_ = 0;
-  height_ = 0;
-  wl_pointer_set_cursor(input_pointer_, serial, NULL, 0, 0);
+void WaylandCursor::RequestFrameCallback() {
+  static const struct wl_callback_listener frame_listener = {
+    WaylandCursor::OnFrameDone
+  };
 
-  if (buffer_) {
-    wl_buffer_destroy(buffer_);
-    buffer_ = NULL;
+  frame_callback_ = wl_surface_frame(pointer_surface_);
+  wl_callback_add_listener(frame_callback_, &frame_listener, this);
+}
+
+void WaylandCursor::StopAnimation() {
+  lock_.AssertAcquired();
+  if (frame_callback_) {
+    wl_callback_destroy(frame_callback_);
+    frame_callback_ = NULL;
   }
+}
 
-  if (sh_memory_->handle().fd) {
-    sh_memory_->Unmap();
-    sh_memory_->Close();
+// static
+void WaylandCursor::OnFrameDone(void* data,
+                                wl_callback* callback,
+                                uint32_t time) {
+  WaylandCursor* cursor = static_cast<WaylandCursor*>(data);
+  base::AutoLock lock(cursor->lock_);
+  // The animation was stopped while the event was being dispatched.
+  if (callback != cursor->frame_callback_)
+    return;
+
+  wl_callback_destroy(callback);
+  cursor->frame_callback_ = NULL;
+  if (base::TimeTicks::Now() - cursor->frame_shown_time_ >=
+      cursor->frames_[cursor->current_frame_].delay) {
+    cursor->current_frame_ = (cursor->current_frame_ + 1) %
+        cursor->frames_.size();
+    cursor->ShowFrame();
+    return;
   }
+
+  // Not yet time for the next frame, check again on the next repaint. The
+  // compositor doesn't repaint a cursor which isn't shown, which pauses the
+  // animation.
+  cursor->RequestFrameCallback();
+  wl_surface_commit(cursor->pointer_surface_);
 }
 
 void WaylandCursor::SetInputPointer(wl_pointer* pointer) {
@@ -6,14 +6,16 @@
 #define OZONE_WAYLAND_INPUT_CURSOR_H_
 
 #include <wayland-client.h>
+
 #include <vector>
 
 #include "base/macros.h"
-#include "third_party/skia/include/core/SkBitmap.h"
+#include "base/synchronization/lock.h"
+#include "base/time/time.h"
+#include "ozone/wayland/input/cursor_cache.h"
+#include "ui/gfx/geometry/size.h"
 
-namespace base {
-class SharedMemory;
-}
+struct wl_cursor;
 
 namespace gfx {
 class Point;
@@ -21,30 +23,57 @@ class Point;
 
 namespace ozonewayland {
 
+class WaylandShmBuffer;
+
+// Animated cursors are played back here rather than by the browser: the
+// next frame is shown from the wl_surface.frame callback of the cursor
+// surface once the frame delay has elapsed. As the callbacks are dispatched
+// on the display thread, the animation state is guarded by |lock_|.
+
 class WaylandCursor {
  public:
   WaylandCursor();
   ~WaylandCursor();
 
-  void UpdateBitmap(const std::vector<SkBitmap>& bitmaps,
-                    const gfx::Point& location,
-                    uint32_t serial);
+  // Shows |cursor|, or hides the cursor if it is NULL or has no frames. The
+  // frames must stay in the cache while they are shown.
+  void UpdateBitmap(const WaylandCursorCache::Entry* cursor, uint32_t serial);
+  // Shows |cursor| from the cursor theme, its images are animated the same
+  // way. They are |scale| times as large as the cursor on screen.
+  void UpdateThemeCursor(wl_cursor* cursor, int scale, uint32_t serial);
   void MoveCursor(const gfx::Point& location, uint32_t serial);
 
   wl_pointer* GetInputPointer() const { return input_pointer_; }
   void SetInputPointer(wl_pointer* pointer);
 
  private:
-  bool CreateSHMBuffer(int width, int height);
+  struct Frame {
+    wl_buffer* buffer;
+    // NULL for the theme cursors, whose buffers belong to libwayland-cursor.
+    WaylandShmBuffer* shm_buffer;
+    gfx::Size size;
+    int scale;
+    base::TimeDelta delay;
+  };
+
+  // Shows |frames_| from the first one. |hotspot| is in surface coordinates.
+  void ShowCursor(const gfx::Point& hotspot, uint32_t serial);
   void HideCursor(uint32_t serial);
+  // Attaches the current frame and, for animated cursors, requests the frame
+  // callback which advances to the next one.
+  void ShowFrame();
+  void RequestFrameCallback();
+  void StopAnimation();
+  static void OnFrameDone(void* data, wl_callback* callback, uint32_t time);
 
   struct wl_pointer* input_pointer_;
   struct wl_surface* pointer_surface_;
-  struct wl_buffer* buffer_;
-  struct wl_shm* shm_;
-  base::SharedMemory* sh_memory_;
-  int width_;
-  int height_;
+  std::vector<Frame> frames_;
+  int buffer_scale_;
+  size_t current_frame_;
+  base::TimeTicks frame_shown_time_;
+  wl_callback* frame_callback_;
+  base::Lock lock_;
   DISALLOW_COPY_AND_ASSIGN(WaylandCursor);
 };
 
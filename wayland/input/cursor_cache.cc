@@ -0,0 +1,120 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/input/cursor_cache.h"
+
+#include <string.h>
+#include <wayland-client.h>
+
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/platform/window_constants.h"
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/shm_arena.h"
+#include "third_party/skia/include/core/SkBitmap.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace ozonewayland {
+
+namespace {
+
+WaylandShmBuffer* UploadBitmap(const SkBitmap& bitmap) {
+  SkAutoLockPixels lock(bitmap);
+  if (bitmap.drawsNothing() || !bitmap.getPixels())
+    return NULL;
+
+  WaylandShmBuffer* buffer =
+      WaylandDisplay::GetInstance()->GetShmArena()->CreateBuffer(
+          gfx::Size(bitmap.width(), bitmap.height()),
+          WL_SHM_FORMAT_ARGB8888,
+          NULL);
+  if (!buffer)
+    return NULL;
+
+  // The |bitmap| contains ARGB image, so just copy it.
+  const uint8_t* src = static_cast<const uint8_t*>(bitmap.getPixels());
+  uint8_t* dst = static_cast<uint8_t*>(buffer->memory());
+  for (int y = 0; y < bitmap.height(); ++y) {
+    memcpy(dst, src, buffer->stride());
+    src += bitmap.rowBytes();
+    dst += buffer->stride();
+  }
+
+  return buffer;
+}
+
+}  // namespace
+
+WaylandCursorCache::Entry::Entry()
+    : id(0) {
+}
+
+WaylandCursorCache::Entry::~Entry() {
+}
+
+WaylandCursorCache::WaylandCursorCache() {
+}
+
+WaylandCursorCache::~WaylandCursorCache() {
+  while (!entries_.empty())
+    Remove(entries_.begin());
+}
+
+const WaylandCursorCache::Entry* WaylandCursorCache::Add(
+    uint64_t id,
+    const std::vector<SkBitmap>& bitmaps,
+    const gfx::Point& hotspot,
+    base::TimeDelta frame_delay) {
+  const Entry* cached = Get(id);
+  if (cached)
+    return cached;
+
+  TRACE_EVENT1("ozone", "WaylandCursorCache::Add", "frames", bitmaps.size());
+  // The entry is added even if the upload fails, so that the eviction order
+  // stays the same as in the browser.
+  entries_.push_front(Entry());
+  Entry& entry = entries_.front();
+  entry.id = id;
+  entry.hotspot = hotspot;
+  entry.frame_delay = frame_delay;
+  for (const SkBitmap& bitmap : bitmaps) {
+    WaylandShmBuffer* buffer = UploadBitmap(bitmap);
+    if (buffer)
+      entry.frames.push_back(buffer);
+  }
+
+  if (entry.frames.size() != bitmaps.size())
+    LOG(ERROR) << "Failed to create SHM buffer for Cursor Bitmap.";
+
+  // The evicted cursor is never the one showing, which is the most recently
+  // used one until the new cursor replaces it.
+  if (entries_.size() > ui::kMaxCachedCursors)
+    Remove(--entries_.end());
+
+  return &entries_.front();
+}
+
+const WaylandCursorCache::Entry* WaylandCursorCache::Get(uint64_t id) {
+  for (std::list<Entry>::iterator it = entries_.begin();
+       it != entries_.end(); ++it) {
+    if (it->id == id) {
+      entries_.splice(entries_.begin(), entries_, it);
+      return &entries_.front();
+    }
+  }
+
+  return NULL;
+}
+
+void WaylandCursorCache::Remove(std::list<Entry>::iterator it) {
+  // The buffers still held by the compositor are recycled by the arena once
+  // released.
+  WaylandShmArena* arena = WaylandDisplay::GetInstance()->GetShmArena();
+  for (WaylandShmBuffer* buffer : it->frames)
+    arena->DestroyBuffer(buffer);
+
+  entries_.erase(it);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,65 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_INPUT_CURSOR_CACHE_H_
+#define OZONE_WAYLAND_INPUT_CURSOR_CACHE_H_
+
+#include <stdint.h>
+
+#include <list>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "ui/gfx/geometry/point.h"
+
+class SkBitmap;
+
+namespace ozonewayland {
+
+class WaylandShmBuffer;
+
+// Cursor bitmaps uploaded to shm buffers, by the id the browser gave them.
+// The least recently used cursor is evicted once kMaxCachedCursors are kept.
+// The browser tracks the cache in the same order (see
+// WindowManagerWayland::UseCursor), so it only sends the bitmaps of the
+// cursors missing here.
+class WaylandCursorCache {
+ public:
+  struct Entry {
+    Entry();
+    ~Entry();
+
+    uint64_t id;
+    // Animated cursors have several frames, shown |frame_delay| apart.
+    std::vector<WaylandShmBuffer*> frames;
+    gfx::Point hotspot;
+    base::TimeDelta frame_delay;
+  };
+
+  WaylandCursorCache();
+  ~WaylandCursorCache();
+
+  // Uploads the frames in |bitmaps| as the most recently used cursor. The
+  // frames which couldn't be uploaded are left out. As ids identify the
+  // content, a cursor which is already cached isn't uploaded again.
+  const Entry* Add(uint64_t id,
+                   const std::vector<SkBitmap>& bitmaps,
+                   const gfx::Point& hotspot,
+                   base::TimeDelta frame_delay);
+  // Returns the cursor |id| and marks it as the most recently used, NULL if
+  // it isn't cached.
+  const Entry* Get(uint64_t id);
+
+ private:
+  void Remove(std::list<Entry>::iterator it);
+
+  // Most recently used first.
+  std::list<Entry> entries_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandCursorCache);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_INPUT_CURSOR_CACHE_H_
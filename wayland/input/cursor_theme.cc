@@ -0,0 +1,137 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/input/cursor_theme.h"
+
+#include <stdlib.h>
+#include <wayland-cursor.h>
+
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+#include "ui/base/cursor/cursor.h"
+
+namespace ozonewayland {
+
+namespace {
+
+const int kDefaultCursorSize = 24;
+
+// Theme cursor names for the Chromium cursor types, first match wins. The X
+// cursor font names come first as all the themes have them.
+const struct {
+  int type;
+  const char* name;
+} kThemeCursors[] = {
+  { ui::kCursorPointer, "left_ptr" },
+  { ui::kCursorCross, "crosshair" },
+  { ui::kCursorCross, "cross" },
+  { ui::kCursorHand, "hand2" },
+  { ui::kCursorHand, "hand1" },
+  { ui::kCursorHand, "pointer" },
+  { ui::kCursorIBeam, "xterm" },
+  { ui::kCursorIBeam, "text" },
+  { ui::kCursorWait, "watch" },
+  { ui::kCursorWait, "wait" },
+  { ui::kCursorHelp, "question_arrow" },
+  { ui::kCursorHelp, "help" },
+  { ui::kCursorEastResize, "right_side" },
+  { ui::kCursorNorthResize, "top_side" },
+  { ui::kCursorNorthEastResize, "top_right_corner" },
+  { ui::kCursorNorthWestResize, "top_left_corner" },
+  { ui::kCursorSouthResize, "bottom_side" },
+  { ui::kCursorSouthEastResize, "bottom_right_corner" },
+  { ui::kCursorSouthWestResize, "bottom_left_corner" },
+  { ui::kCursorWestResize, "left_side" },
+  { ui::kCursorNorthSouthResize, "sb_v_double_arrow" },
+  { ui::kCursorNorthSouthResize, "ns-resize" },
+  { ui::kCursorEastWestResize, "sb_h_double_arrow" },
+  { ui::kCursorEastWestResize, "ew-resize" },
+  { ui::kCursorColumnResize, "sb_h_double_arrow" },
+  { ui::kCursorColumnResize, "col-resize" },
+  { ui::kCursorRowResize, "sb_v_double_arrow" },
+  { ui::kCursorRowResize, "row-resize" },
+  { ui::kCursorMove, "fleur" },
+  { ui::kCursorMove, "move" },
+  { ui::kCursorProgress, "left_ptr_watch" },
+  { ui::kCursorProgress, "progress" },
+  { ui::kCursorNotAllowed, "crossed_circle" },
+  { ui::kCursorNotAllowed, "not-allowed" },
+  { ui::kCursorNoDrop, "crossed_circle" },
+  { ui::kCursorNoDrop, "no-drop" },
+  { ui::kCursorGrab, "openhand" },
+  { ui::kCursorGrab, "grab" },
+  { ui::kCursorGrabbing, "grabbing" },
+  { ui::kCursorGrabbing, "closedhand" },
+  { ui::kCursorCopy, "copy" },
+  { ui::kCursorAlias, "dnd-link" },
+  { ui::kCursorAlias, "alias" },
+  { ui::kCursorContextMenu, "context-menu" },
+  { ui::kCursorCell, "cell" },
+  { ui::kCursorCell, "plus" },
+  { ui::kCursorVerticalText, "vertical-text" },
+  { ui::kCursorZoomIn, "zoom-in" },
+  { ui::kCursorZoomOut, "zoom-out" },
+};
+
+}  // namespace
+
+WaylandCursorTheme::WaylandCursorTheme()
+    : theme_(NULL),
+      scale_(1) {
+}
+
+WaylandCursorTheme::~WaylandCursorTheme() {
+  if (theme_)
+    wl_cursor_theme_destroy(theme_);
+}
+
+bool WaylandCursorTheme::Load(wl_shm* shm, int scale) {
+  DCHECK(!theme_);
+  TRACE_EVENT0("ozone", "WaylandCursorTheme::Load");
+  int size = kDefaultCursorSize;
+  char* env;
+  if ((env = getenv("XCURSOR_SIZE")) && atoi(env) > 0)
+    size = atoi(env);
+
+  // libwayland-cursor falls back to its built-in cursors when the theme
+  // can't be found.
+  theme_ = wl_cursor_theme_load(getenv("XCURSOR_THEME"), size * scale, shm);
+  if (!theme_) {
+    LOG(ERROR) << "Failed to load the cursor theme";
+    return false;
+  }
+
+  scale_ = scale;
+  return true;
+}
+
+wl_cursor* WaylandCursorTheme::GetCursor(int type) const {
+  if (!theme_)
+    return NULL;
+
+  for (size_t i = 0; i < arraysize(kThemeCursors); ++i) {
+    if (kThemeCursors[i].type != type)
+      continue;
+
+    wl_cursor* cursor =
+        wl_cursor_theme_get_cursor(theme_, kThemeCursors[i].name);
+    if (cursor && cursor->image_count)
+      return cursor;
+  }
+
+  return NULL;
+}
+
+std::vector<int> WaylandCursorTheme::GetSupportedTypes() const {
+  std::vector<int> types;
+  for (size_t i = 0; i < arraysize(kThemeCursors); ++i) {
+    int type = kThemeCursors[i].type;
+    if ((types.empty() || types.back() != type) && GetCursor(type))
+      types.push_back(type);
+  }
+
+  return types;
+}
+
+}  // namespace ozonewayland
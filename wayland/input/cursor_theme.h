@@ -0,0 +1,49 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_INPUT_CURSOR_THEME_H_
+#define OZONE_WAYLAND_INPUT_CURSOR_THEME_H_
+
+#include <wayland-client.h>
+
+#include <vector>
+
+#include "base/macros.h"
+
+struct wl_cursor;
+struct wl_cursor_theme;
+
+namespace ozonewayland {
+
+// The XCursor theme loaded by libwayland-cursor, used for the standard
+// Chromium cursors. All of its cursors are loaded up front into a single
+// wl_shm pool, so showing one of them costs neither an upload nor memory of
+// its own.
+class WaylandCursorTheme {
+ public:
+  WaylandCursorTheme();
+  ~WaylandCursorTheme();
+
+  // Loads XCURSOR_THEME at XCURSOR_SIZE, or the default theme, with images
+  // |scale| times as large. This reads the theme files, so it has to happen
+  // before the sandbox is engaged.
+  bool Load(wl_shm* shm, int scale);
+
+  // Returns the cursor for |type| (ui::CursorType), NULL if the theme has
+  // none.
+  wl_cursor* GetCursor(int type) const;
+  // The types GetCursor has a cursor for.
+  std::vector<int> GetSupportedTypes() const;
+  // The buffer scale of the cursor images.
+  int scale() const { return scale_; }
+
+ private:
+  wl_cursor_theme* theme_;
+  int scale_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandCursorTheme);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_INPUT_CURSOR_THEME_H_
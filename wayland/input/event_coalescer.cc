@@ -0,0 +1,50 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/input/event_coalescer.h"
+
+namespace ozonewayland {
+
+WaylandEventCoalescer::WaylandEventCoalescer() {
+}
+
+WaylandEventCoalescer::~WaylandEventCoalescer() {
+}
+
+void WaylandEventCoalescer::Queue(const ui::InputEventRecord& event) {
+  if (events_.empty()) {
+    first_event_time_ = base::TimeTicks::Now();
+    events_.push_back(event);
+    return;
+  }
+
+  ui::InputEventRecord& last = events_.back();
+  if (last.kind != event.kind || last.device_id != event.device_id) {
+    events_.push_back(event);
+    return;
+  }
+
+  switch (event.kind) {
+    case ui::INPUT_MOTION:
+      last.kind = ui::INPUT_MOTION_HISTORY;
+      events_.push_back(event);
+      break;
+    case ui::INPUT_AXIS:
+      last.position = event.position;
+      last.x_offset += event.x_offset;
+      last.y_offset += event.y_offset;
+      break;
+    default:
+      events_.push_back(event);
+      break;
+  }
+}
+
+void WaylandEventCoalescer::TakeEvents(
+    std::vector<ui::InputEventRecord>* events) {
+  events->clear();
+  events->swap(events_);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,43 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_INPUT_EVENT_COALESCER_H_
+#define OZONE_WAYLAND_INPUT_EVENT_COALESCER_H_
+
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "ozone/platform/window_constants.h"
+
+namespace ozonewayland {
+
+// WaylandEventCoalescer accumulates the pointer and touch events which are
+// sent together to the browser. Consecutive motion events of the same device
+// are merged into the latest one, consecutive axis events of the same device
+// have their offsets summed. Any other event ends the merging, so ordering is
+// preserved. The merged motion samples stay in the batch right before the
+// latest one, as INPUT_MOTION_HISTORY records, for the consumers which need
+// all of them. This class is not thread safe.
+class WaylandEventCoalescer {
+ public:
+  WaylandEventCoalescer();
+  ~WaylandEventCoalescer();
+
+  void Queue(const ui::InputEventRecord& event);
+  bool HasPendingEvents() const { return !events_.empty(); }
+  // Time at which the oldest pending event was queued.
+  base::TimeTicks first_event_time() const { return first_event_time_; }
+  // Moves the pending events to |events|.
+  void TakeEvents(std::vector<ui::InputEventRecord>* events);
+
+ private:
+  std::vector<ui::InputEventRecord> events_;
+  base::TimeTicks first_event_time_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandEventCoalescer);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_INPUT_EVENT_COALESCER_H_
@@ -10,7 +10,8 @@
 namespace ozonewayland {
 
 WaylandKeyboard::WaylandKeyboard() : input_keyboard_(NULL),
-    dispatcher_(NULL) {
+    dispatcher_(NULL),
+    entered_window_handle_(0) {
 }
 
 WaylandKeyboard::~WaylandKeyboard() {
@@ -97,6 +98,11 @@ void WaylandKeyboard::OnKeyboardEnter(void* data,
   WaylandWindow* window =
     static_cast<WaylandWindow*>(wl_surface_get_user_data(surface));
   unsigned handle = window->Handle();
+  if (device->entered_window_handle_ != handle) {
+    device->entered_window_handle_ = handle;
+    window->ShellSurface()->InvalidateSeatAcceptance();
+  }
+
   seat->SetKeyboardFocusWindowHandle(handle);
   device->dispatcher_->KeyboardEnter(handle);
 }
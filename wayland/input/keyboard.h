@@ -54,6 +54,8 @@ class WaylandKeyboard {
   WaylandDisplay* dispatcher_;
   WaylandSeat* seat_;
   uint32_t device_id_;
+  // The window the keyboard last entered, kept when it leaves.
+  unsigned entered_window_handle_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandKeyboard);
 };
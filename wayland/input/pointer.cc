@@ -17,6 +17,7 @@ namespace ozonewayland {
 WaylandPointer::WaylandPointer()
   : cursor_(NULL),
     dispatcher_(NULL),
+    entered_window_handle_(0),
     pointer_position_(0, 0),
     input_pointer_(NULL) {
 }
@@ -67,7 +68,7 @@ void WaylandPointer::OnMotionNotify(void* data,
       return;
   }
 
-  device->dispatcher_->MotionNotify(sx, sy, device->device_id_);
+  device->dispatcher_->MotionNotify(sx, sy, time, device->device_id_);
 }
 
 void WaylandPointer::OnButtonNotify(void* data,
@@ -156,8 +157,20 @@ void WaylandPointer::OnPointerEnter(void* data,
 
   WaylandWindow* window =
       static_cast<WaylandWindow*>(wl_surface_get_user_data(surface));
-  if (!window || !window->ShellSurface()->CanAcceptSeatEvents(seat_name.c_str()))
-      return;
+  if (!window)
+    return;
+
+  // The compositor only lets a seat enter the surfaces accepting it, so the
+  // acceptance cached by the window is only worth querying again once the
+  // pointer has been somewhere else.
+  if (device->entered_window_handle_ != window->Handle()) {
+    device->entered_window_handle_ = window->Handle();
+    window->ShellSurface()->InvalidateSeatAcceptance();
+  }
+
+  if (!window->ShellSurface()->CanAcceptSeatEvents(seat_name.c_str()))
+    return;
+
   unsigned handle = window->Handle();
   float sx = wl_fixed_to_double(sx_w);
   float sy = wl_fixed_to_double(sy_w);
@@ -63,6 +63,8 @@ class WaylandPointer {
   WaylandDisplay* dispatcher_;
   WaylandSeat* seat_;
   uint32_t device_id_;
+  // The window the pointer last entered, kept when it leaves.
+  unsigned entered_window_handle_;
 
   // Keeps track of the last position for the motion event. We want to
   // dispatch this with events such as wheel or button which don't have a
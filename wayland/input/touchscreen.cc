@@ -136,7 +136,10 @@ void WaylandTouchscreen::OnTouchMotion(void *data,
 
 void WaylandTouchscreen::OnTouchFrame(void *data,
                                       struct wl_touch *wl_touch) {
-  // TODO(speedpat): find out what should be done here
+  // All the touch points of this frame have been reported, deliver them
+  // together.
+  WaylandTouchscreen* device = static_cast<WaylandTouchscreen*>(data);
+  device->dispatcher_->FlushInputEvents();
 }
 
 void WaylandTouchscreen::OnTouchCancel(void *data,
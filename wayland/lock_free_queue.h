@@ -0,0 +1,103 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_LOCK_FREE_QUEUE_H_
+#define OZONE_WAYLAND_LOCK_FREE_QUEUE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+
+#include "base/atomicops.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace ozonewayland {
+
+// A bounded lock-free queue with any number of producers and a single
+// consumer. Every cell carries a sequence number telling whether it is ready
+// to be written or read for a given position, so producers only contend on the
+// enqueue position. |capacity| must be a power of two.
+template <typename T>
+class LockFreeQueue {
+ public:
+  explicit LockFreeQueue(size_t capacity)
+      : cells_(new Cell[capacity]),
+        mask_(capacity - 1),
+        enqueue_pos_(0),
+        dequeue_pos_(0) {
+    DCHECK(capacity >= 2 && !(capacity & mask_));
+    for (size_t i = 0; i < capacity; ++i)
+      base::subtle::NoBarrier_Store(&cells_[i].sequence, i);
+  }
+
+  // Returns false if the queue is full. Can be called from any thread.
+  bool Push(const T& value) {
+    Cell* cell;
+    base::subtle::Atomic32 pos =
+        base::subtle::NoBarrier_Load(&enqueue_pos_);
+    while (1) {
+      cell = &cells_[pos & mask_];
+      base::subtle::Atomic32 sequence =
+          base::subtle::Acquire_Load(&cell->sequence);
+      int32_t diff = static_cast<int32_t>(sequence - pos);
+      if (!diff) {
+        base::subtle::Atomic32 previous =
+            base::subtle::NoBarrier_CompareAndSwap(&enqueue_pos_, pos, pos + 1);
+        if (previous == pos)
+          break;
+        pos = previous;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = base::subtle::NoBarrier_Load(&enqueue_pos_);
+      }
+    }
+
+    cell->value = value;
+    base::subtle::Release_Store(&cell->sequence, pos + 1);
+    return true;
+  }
+
+  // Returns false if the queue is empty. Must always be called from the same
+  // thread.
+  bool Pop(T* value) {
+    base::subtle::Atomic32 pos = base::subtle::NoBarrier_Load(&dequeue_pos_);
+    Cell* cell = &cells_[pos & mask_];
+    base::subtle::Atomic32 sequence =
+        base::subtle::Acquire_Load(&cell->sequence);
+    if (static_cast<int32_t>(sequence - (pos + 1)) < 0)
+      return false;
+
+    *value = cell->value;
+    base::subtle::Release_Store(&cell->sequence, pos + mask_ + 1);
+    base::subtle::Release_Store(&dequeue_pos_, pos + 1);
+    return true;
+  }
+
+  // Number of values pushed but not popped yet. Only approximate while
+  // producers are running.
+  size_t Size() const {
+    return static_cast<uint32_t>(
+        base::subtle::Acquire_Load(&enqueue_pos_) -
+        base::subtle::Acquire_Load(&dequeue_pos_));
+  }
+
+ private:
+  struct Cell {
+    base::subtle::Atomic32 sequence;
+    T value;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  const uint32_t mask_;
+  base::subtle::Atomic32 enqueue_pos_;
+  base::subtle::Atomic32 dequeue_pos_;
+  DISALLOW_COPY_AND_ASSIGN(LockFreeQueue);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_LOCK_FREE_QUEUE_H_
@@ -4,18 +4,56 @@
 
 #include "ozone/wayland/ozone_wayland_screen.h"
 
+#include <string>
+
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/path_service.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/thread_restrictions.h"
+#include "base/threading/worker_pool.h"
 #include "ozone/platform/desktop_platform_screen_delegate.h"
 #include "ozone/platform/window_manager_wayland.h"
-#include "ozone/wayland/screen.h"
 
 namespace ozonewayland {
 
+namespace {
+
+const char kOutputGeometryFile[] = "ozone-wayland-output-geometry";
+
+// Used until the GPU process reports the output size when nothing is cached.
+const int kDefaultOutputWidth = 1920;
+const int kDefaultOutputHeight = 1080;
+
+bool GetOutputGeometryPath(base::FilePath* path) {
+  base::FilePath cache_dir;
+  if (!PathService::Get(base::DIR_CACHE, &cache_dir))
+    return false;
+
+  *path = cache_dir.Append(kOutputGeometryFile);
+  return true;
+}
+
+void WriteOutputGeometry(const gfx::Size& size) {
+  base::FilePath path;
+  if (!GetOutputGeometryPath(&path))
+    return;
+
+  base::ImportantFileWriter::WriteFileAtomically(
+      path, base::StringPrintf("%d %d", size.width(), size.height()));
+}
+
+}  // namespace
+
 OzoneWaylandScreen::OzoneWaylandScreen(
     ui::DesktopPlatformScreenDelegate* observer,
     ui::WindowManagerWayland* window_manager)
-  : look_ahead_screen_(NULL),
-    observer_(observer) {
-  LookAheadOutputGeometry();
+  : observer_(observer) {
+  LoadCachedOutputGeometry();
   window_manager->OnPlatformScreenCreated(this);
 }
 
@@ -26,48 +64,44 @@ gfx::Point OzoneWaylandScreen::GetCursorScreenPoint() {
   return gfx::Point();
 }
 
-void OzoneWaylandScreen::LookAheadOutputGeometry() {
-  wl_display* display = wl_display_connect(NULL);
-  if (!display)
-    return;
-
-  static const struct wl_registry_listener registry_output = {
-    OzoneWaylandScreen::DisplayHandleOutputOnly
-  };
+void OzoneWaylandScreen::OnOutputSizeChanged(unsigned width,
+                                             unsigned height) {
+  observer_->OnOutputSizeChanged(width, height);
 
-  wl_registry* registry = wl_display_get_registry(display);
-  wl_registry_add_listener(registry, &registry_output, this);
+  gfx::Size size(width, height);
+  if (size == output_size_ || size.IsEmpty())
+    return;
 
-  if (wl_display_roundtrip(display) > 0) {
-    while (look_ahead_screen_->Geometry().IsEmpty())
-      wl_display_roundtrip(display);
+  output_size_ = size;
+  base::WorkerPool::PostTask(FROM_HERE,
+                             base::Bind(&WriteOutputGeometry, output_size_),
+                             true);
+}
 
-    unsigned width = look_ahead_screen_->Geometry().width();
-    unsigned height = look_ahead_screen_->Geometry().height();
-    observer_->OnOutputSizeChanged(width, height);
+void OzoneWaylandScreen::LoadCachedOutputGeometry() {
+  base::FilePath path;
+  std::string contents;
+  {
+    // The file is a few bytes long and read once, at startup.
+    base::ThreadRestrictions::ScopedAllowIO allow_io;
+    if (GetOutputGeometryPath(&path))
+      base::ReadFileToString(path, &contents);
   }
 
-  if (look_ahead_screen_) {
-    delete look_ahead_screen_;
-    look_ahead_screen_ = NULL;
+  std::vector<std::string> values = base::SplitString(
+      contents, " ", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+  int width, height;
+  if (values.size() == 2 &&
+      base::StringToInt(values[0], &width) &&
+      base::StringToInt(values[1], &height) &&
+      width > 0 && height > 0) {
+    output_size_ = gfx::Size(width, height);
+  } else {
+    width = kDefaultOutputWidth;
+    height = kDefaultOutputHeight;
   }
 
-  wl_registry_destroy(registry);
-  wl_display_flush(display);
-  wl_display_disconnect(display);
-}
-
-void OzoneWaylandScreen::DisplayHandleOutputOnly(void *data,
-                                                 struct wl_registry *registry,
-                                                 uint32_t name,
-                                                 const char *interface,
-                                                 uint32_t version) {
-  OzoneWaylandScreen* disp = static_cast<OzoneWaylandScreen*>(data);
-
-  if (strcmp(interface, "wl_output") == 0) {
-    WaylandScreen* screen = new WaylandScreen(registry, name);
-    disp->look_ahead_screen_ = screen;
-  }
+  observer_->OnOutputSizeChanged(width, height);
 }
 
 }  // namespace ozonewayland
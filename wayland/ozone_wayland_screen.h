@@ -5,9 +5,8 @@
 #ifndef OZONE_WAYLAND_OZONE_WAYLAND_SCREEN_H_
 #define OZONE_WAYLAND_OZONE_WAYLAND_SCREEN_H_
 
-#include <wayland-client.h>
-
 #include "ozone/platform/desktop_platform_screen.h"
+#include "ui/gfx/geometry/size.h"
 
 namespace ui {
 class DesktopPlatformScreenDelegate;
@@ -16,8 +15,6 @@ class WindowManagerWayland;
 
 namespace ozonewayland {
 
-class WaylandScreen;
-
 class OzoneWaylandScreen : public ui::DesktopPlatformScreen {
  public:
   OzoneWaylandScreen(ui::DesktopPlatformScreenDelegate* observer,
@@ -28,18 +25,18 @@ class OzoneWaylandScreen : public ui::DesktopPlatformScreen {
   gfx::Point GetCursorScreenPoint() override;
   ui::DesktopPlatformScreenDelegate* GetDelegate() const { return observer_; }
 
+  // Called when the GPU process reports the size of the output. Notifies the
+  // delegate and updates the cached geometry if needed.
+  void OnOutputSizeChanged(unsigned width, unsigned height);
+
  private:
-  void LookAheadOutputGeometry();
-  // This handler resolves only screen registration. In general you don't want
-  // to use this but the one below.
-  static void DisplayHandleOutputOnly(
-      void *data,
-      struct wl_registry *registry,
-      uint32_t name,
-      const char *interface,
-      uint32_t version);
-  WaylandScreen* look_ahead_screen_;
+  // The browser starts with the output size of the last run, read from the
+  // cache directory, so that it doesn't need its own connection to the
+  // compositor. The GPU process sends the actual size as soon as it knows it.
+  void LoadCachedOutputGeometry();
+
   ui::DesktopPlatformScreenDelegate* observer_;
+  gfx::Size output_size_;
 };
 
 }  // namespace ozonewayland
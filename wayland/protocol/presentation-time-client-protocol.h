@@ -0,0 +1,249 @@
+/* 
+ * Copyright © 2013-2014 Collabora, Ltd.
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice (including the next
+ * paragraph) shall be included in all copies or substantial portions of the
+ * Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PRESENTATION_TIME_CLIENT_PROTOCOL_H
+#define PRESENTATION_TIME_CLIENT_PROTOCOL_H
+
+#ifdef  __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "wayland-client.h"
+
+struct wl_client;
+struct wl_resource;
+
+struct wl_output;
+struct wl_surface;
+struct wp_presentation;
+struct wp_presentation_feedback;
+
+extern const struct wl_interface wp_presentation_interface;
+extern const struct wl_interface wp_presentation_feedback_interface;
+
+#ifndef WP_PRESENTATION_ERROR_ENUM
+#define WP_PRESENTATION_ERROR_ENUM
+/**
+ * wp_presentation_error - fatal presentation errors
+ * @WP_PRESENTATION_ERROR_INVALID_TIMESTAMP: invalid value in tv_nsec
+ * @WP_PRESENTATION_ERROR_INVALID_FLAG: invalid flag
+ *
+ * These fatal protocol errors may be emitted in response to illegal
+ * presentation requests.
+ */
+enum wp_presentation_error {
+	WP_PRESENTATION_ERROR_INVALID_TIMESTAMP = 0,
+	WP_PRESENTATION_ERROR_INVALID_FLAG = 1,
+};
+#endif /* WP_PRESENTATION_ERROR_ENUM */
+
+/**
+ * wp_presentation - timed presentation related wl_surface requests
+ * @clock_id: clock ID for timestamps
+ *
+ * The main feature of this interface is accurate presentation timing
+ * feedback to ensure smooth video playback while maintaining audio/video
+ * synchronization. Some features use the concept of a presentation clock,
+ * which is defined in the presentation.clock_id event.
+ */
+struct wp_presentation_listener {
+	/**
+	 * clock_id - clock ID for timestamps
+	 * @clk_id: platform clock identifier
+	 *
+	 * This event tells the client in which clock domain the
+	 * compositor interprets the timestamps used by the presentation
+	 * extension. This clock is called the presentation clock.
+	 *
+	 * The compositor sends this event when the client binds to the
+	 * presentation interface. The presentation clock does not change
+	 * during the lifetime of the client connection.
+	 *
+	 * The clock identifier is platform dependent. On Linux/glibc, the
+	 * identifier value is one of the clockid_t values accepted by
+	 * clock_gettime().
+	 */
+	void (*clock_id)(void *data,
+			 struct wp_presentation *wp_presentation,
+			 uint32_t clk_id);
+};
+
+static inline int
+wp_presentation_add_listener(struct wp_presentation *wp_presentation,
+			     const struct wp_presentation_listener *listener, void *data)
+{
+	return wl_proxy_add_listener((struct wl_proxy *) wp_presentation,
+				     (void (**)(void)) listener, data);
+}
+
+#define WP_PRESENTATION_DESTROY	0
+#define WP_PRESENTATION_FEEDBACK	1
+
+static inline void
+wp_presentation_set_user_data(struct wp_presentation *wp_presentation, void *user_data)
+{
+	wl_proxy_set_user_data((struct wl_proxy *) wp_presentation, user_data);
+}
+
+static inline void *
+wp_presentation_get_user_data(struct wp_presentation *wp_presentation)
+{
+	return wl_proxy_get_user_data((struct wl_proxy *) wp_presentation);
+}
+
+static inline void
+wp_presentation_destroy(struct wp_presentation *wp_presentation)
+{
+	wl_proxy_marshal((struct wl_proxy *) wp_presentation,
+			 WP_PRESENTATION_DESTROY);
+
+	wl_proxy_destroy((struct wl_proxy *) wp_presentation);
+}
+
+static inline struct wp_presentation_feedback *
+wp_presentation_feedback(struct wp_presentation *wp_presentation, struct wl_surface *surface)
+{
+	struct wl_proxy *callback;
+
+	callback = wl_proxy_marshal_constructor((struct wl_proxy *) wp_presentation,
+			 WP_PRESENTATION_FEEDBACK, &wp_presentation_feedback_interface, surface, NULL);
+
+	return (struct wp_presentation_feedback *) callback;
+}
+
+#ifndef WP_PRESENTATION_FEEDBACK_KIND_ENUM
+#define WP_PRESENTATION_FEEDBACK_KIND_ENUM
+/**
+ * wp_presentation_feedback_kind - bitmask of flags in presented event
+ * @WP_PRESENTATION_FEEDBACK_KIND_VSYNC: presentation was vsync'd
+ * @WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK: hardware provided the
+ *	presentation timestamp
+ * @WP_PRESENTATION_FEEDBACK_KIND_HW_COMPLETION: hardware signalled the
+ *	start of the presentation
+ * @WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY: presentation was done
+ *	zero-copy
+ *
+ * These flags provide information about how the presentation of the
+ * related content update was done.
+ */
+enum wp_presentation_feedback_kind {
+	WP_PRESENTATION_FEEDBACK_KIND_VSYNC = 0x1,
+	WP_PRESENTATION_FEEDBACK_KIND_HW_CLOCK = 0x2,
+	WP_PRESENTATION_FEEDBACK_KIND_HW_COMPLETION = 0x4,
+	WP_PRESENTATION_FEEDBACK_KIND_ZERO_COPY = 0x8,
+};
+#endif /* WP_PRESENTATION_FEEDBACK_KIND_ENUM */
+
+/**
+ * wp_presentation_feedback - presentation time feedback event
+ * @sync_output: presentation synchronized to this output
+ * @presented: the content update was displayed
+ * @discarded: the content update was not displayed
+ *
+ * A presentation_feedback object returns an indication that a
+ * wl_surface content update has become visible to the user. One object
+ * corresponds to one content update submission (wl_surface.commit).
+ * Once the presentation_feedback object has delivered a 'presented' or
+ * 'discarded' event it is automatically destroyed.
+ */
+struct wp_presentation_feedback_listener {
+	/**
+	 * sync_output - presentation synchronized to this output
+	 * @output: presentation output
+	 *
+	 * As presentation can be synchronized to only one output at a
+	 * time, this event tells which output it was. This event is only
+	 * sent prior to the presented event.
+	 */
+	void (*sync_output)(void *data,
+			    struct wp_presentation_feedback *wp_presentation_feedback,
+			    struct wl_output *output);
+	/**
+	 * presented - the content update was displayed
+	 * @tv_sec_hi: high 32 bits of the seconds part of the
+	 *	presentation timestamp
+	 * @tv_sec_lo: low 32 bits of the seconds part of the
+	 *	presentation timestamp
+	 * @tv_nsec: nanoseconds part of the presentation timestamp
+	 * @refresh: nanoseconds till next refresh
+	 * @seq_hi: high 32 bits of refresh counter
+	 * @seq_lo: low 32 bits of refresh counter
+	 * @flags: combination of 'kind' values
+	 *
+	 * The associated content update was displayed to the user at the
+	 * indicated time (tv_sec_hi/lo, tv_nsec). The timestamp is in the
+	 * clock domain announced by presentation.clock_id. 'refresh' is
+	 * the prediction of how many nanoseconds after tv_sec, tv_nsec the
+	 * very next output refresh may occur, or zero if unknown.
+	 */
+	void (*presented)(void *data,
+			  struct wp_presentation_feedback *wp_presentation_feedback,
+			  uint32_t tv_sec_hi,
+			  uint32_t tv_sec_lo,
+			  uint32_t tv_nsec,
+			  uint32_t refresh,
+			  uint32_t seq_hi,
+			  uint32_t seq_lo,
+			  uint32_t flags);
+	/**
+	 * discarded - the content update was not displayed
+	 *
+	 * The content update was never displayed to the user.
+	 */
+	void (*discarded)(void *data,
+			  struct wp_presentation_feedback *wp_presentation_feedback);
+};
+
+static inline int
+wp_presentation_feedback_add_listener(struct wp_presentation_feedback *wp_presentation_feedback,
+				      const struct wp_presentation_feedback_listener *listener, void *data)
+{
+	return wl_proxy_add_listener((struct wl_proxy *) wp_presentation_feedback,
+				     (void (**)(void)) listener, data);
+}
+
+static inline void
+wp_presentation_feedback_set_user_data(struct wp_presentation_feedback *wp_presentation_feedback, void *user_data)
+{
+	wl_proxy_set_user_data((struct wl_proxy *) wp_presentation_feedback, user_data);
+}
+
+static inline void *
+wp_presentation_feedback_get_user_data(struct wp_presentation_feedback *wp_presentation_feedback)
+{
+	return wl_proxy_get_user_data((struct wl_proxy *) wp_presentation_feedback);
+}
+
+static inline void
+wp_presentation_feedback_destroy(struct wp_presentation_feedback *wp_presentation_feedback)
+{
+	wl_proxy_destroy((struct wl_proxy *) wp_presentation_feedback);
+}
+
+#ifdef  __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,55 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/render_scale_policy.h"
+
+#include <algorithm>
+
+namespace ozonewayland {
+
+namespace {
+
+const float kScaleStep = 0.1f;
+// Consecutive late frames before lowering the scale.
+const int kMissedFramesToLower = 3;
+// Consecutive frames on time before raising it again, about a second.
+const int kFramesOnTimeToRaise = 60;
+// Beyond this many refresh intervals the window was idle rather than late.
+const int kIdleIntervals = 4;
+
+}  // namespace
+
+DeadlineRenderScalePolicy::DeadlineRenderScalePolicy(float min_scale)
+    : min_scale_(std::min(std::max(min_scale, kScaleStep), 1.f)),
+      missed_frames_(0),
+      frames_on_time_(0) {
+}
+
+DeadlineRenderScalePolicy::~DeadlineRenderScalePolicy() {
+}
+
+float DeadlineRenderScalePolicy::DidSwapFrame(base::TimeDelta since_last_frame,
+                                              base::TimeDelta refresh_interval,
+                                              float current_scale) {
+  if (since_last_frame > refresh_interval * kIdleIntervals)
+    return current_scale;
+
+  if (since_last_frame > refresh_interval) {
+    frames_on_time_ = 0;
+    if (++missed_frames_ < kMissedFramesToLower)
+      return current_scale;
+
+    missed_frames_ = 0;
+    return std::max(current_scale - kScaleStep, min_scale_);
+  }
+
+  missed_frames_ = 0;
+  if (++frames_on_time_ < kFramesOnTimeToRaise)
+    return current_scale;
+
+  frames_on_time_ = 0;
+  return std::min(current_scale + kScaleStep, 1.f);
+}
+
+}  // namespace ozonewayland
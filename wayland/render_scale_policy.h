@@ -0,0 +1,48 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_RENDER_SCALE_POLICY_H_
+#define OZONE_WAYLAND_RENDER_SCALE_POLICY_H_
+
+#include "base/macros.h"
+#include "base/time/time.h"
+
+namespace ozonewayland {
+
+// Decides at which fraction of its size a window is rendered. The compositor
+// scales the result back up with wp_viewporter.
+class WaylandRenderScalePolicy {
+ public:
+  virtual ~WaylandRenderScalePolicy() {}
+
+  // Called for every swap with the time elapsed since the compositor last
+  // repainted the window. Returns the render scale to use, in (0, 1].
+  virtual float DidSwapFrame(base::TimeDelta since_last_frame,
+                             base::TimeDelta refresh_interval,
+                             float current_scale) = 0;
+};
+
+// Lowers the scale in steps when frames keep missing the repaint following
+// the previous one, and raises it back once they have been on time for a
+// while.
+class DeadlineRenderScalePolicy : public WaylandRenderScalePolicy {
+ public:
+  explicit DeadlineRenderScalePolicy(float min_scale);
+  ~DeadlineRenderScalePolicy() override;
+
+  // WaylandRenderScalePolicy:
+  float DidSwapFrame(base::TimeDelta since_last_frame,
+                     base::TimeDelta refresh_interval,
+                     float current_scale) override;
+
+ private:
+  float min_scale_;
+  int missed_frames_;
+  int frames_on_time_;
+  DISALLOW_COPY_AND_ASSIGN(DeadlineRenderScalePolicy);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_RENDER_SCALE_POLICY_H_
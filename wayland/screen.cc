@@ -7,21 +7,30 @@
 
 #include <wayland-client.h>
 
+#include <algorithm>
+
 #include "ozone/wayland/display.h"
 
 namespace ozonewayland {
 
-WaylandScreen::WaylandScreen(wl_registry* registry, uint32_t id)
+WaylandScreen::WaylandScreen(wl_registry* registry,
+                             uint32_t id,
+                             uint32_t version)
     : output_(NULL),
       refresh_(0),
-      rect_(0, 0, 0, 0) {
+      rect_(0, 0, 0, 0),
+      scale_(1) {
   static const wl_output_listener kOutputListener = {
     WaylandScreen::OutputHandleGeometry,
     WaylandScreen::OutputHandleMode,
+    WaylandScreen::OutputHandleDone,
+    WaylandScreen::OutputHandleScale,
   };
 
-  output_ = static_cast<wl_output*>(
-      wl_registry_bind(registry, id, &wl_output_interface, 1));
+  // Version 2 adds the scale.
+  output_ = static_cast<wl_output*>(wl_registry_bind(
+      registry, id, &wl_output_interface,
+      std::min<uint32_t>(version, WL_OUTPUT_SCALE_SINCE_VERSION)));
   wl_output_add_listener(output_, &kOutputListener, this);
   DCHECK(output_);
 }
@@ -65,4 +74,16 @@ void WaylandScreen::OutputHandleMode(void* data,
   }
 }
 
+// static
+void WaylandScreen::OutputHandleDone(void* data, wl_output* output) {
+}
+
+// static
+void WaylandScreen::OutputHandleScale(void* data,
+                                      wl_output* output,
+                                      int32_t factor) {
+  WaylandScreen* screen = static_cast<WaylandScreen*>(data);
+  screen->scale_ = factor;
+}
+
 }  // namespace ozonewayland
@@ -22,11 +22,16 @@ class WaylandDisplay;
 // that are available to the application.
 class WaylandScreen {
  public:
-  WaylandScreen(wl_registry* registry, uint32_t id);
+  WaylandScreen(wl_registry* registry, uint32_t id, uint32_t version);
   ~WaylandScreen();
 
   // Returns the active allocation of the screen.
   gfx::Rect Geometry() const { return rect_; }
+  // Returns the refresh rate of the active mode, in mHz. 0 if unknown.
+  int32_t RefreshRate() const { return refresh_; }
+  // Returns the scale the compositor renders client buffers at, 1 if unknown.
+  int32_t Scale() const { return scale_; }
+  wl_output* GetOutput() const { return output_; }
 
  private:
   // Callback functions that allows the display to initialize the screen's
@@ -49,12 +54,19 @@ class WaylandScreen {
                                int32_t height,
                                int32_t refresh);
 
+  static void OutputHandleDone(void* data, wl_output* output);
+
+  static void OutputHandleScale(void* data,
+                                wl_output* output,
+                                int32_t factor);
+
   // The Wayland output this object wraps
   wl_output* output_;
 
   // Rect and Refresh rate of active mode.
   int32_t refresh_;
   gfx::Rect rect_;
+  int32_t scale_;
 
   DISALLOW_COPY_AND_ASSIGN(WaylandScreen);
 };
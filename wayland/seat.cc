@@ -35,6 +35,9 @@ WaylandSeat::WaylandSeat(WaylandDisplay* display,
   seat_ = static_cast<wl_seat*>(
       wl_registry_bind(display->registry(), id, &wl_seat_interface, 2));
   DCHECK(seat_);
+  // The pointer, keyboard and touch objects inherit the queue of the seat.
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(seat_),
+                     display->GetInputQueue());
   wl_seat_add_listener(seat_, &kInputSeatListener, this);
   wl_seat_set_user_data(seat_, this);
 
@@ -112,14 +115,23 @@ void WaylandSeat::SetGrabWindowHandle(unsigned windowhandle, uint32_t button) {
   grab_button_ = button;
 }
 
-void WaylandSeat::SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                                  const gfx::Point& location) {
+void WaylandSeat::SetCursorBitmap(const WaylandCursorCache::Entry* cursor) {
   if (!input_pointer_) {
     LOG(WARNING) << "Tried to change cursor without input configured";
     return;
   }
   input_pointer_->Cursor()->UpdateBitmap(
-      bitmaps, location, WaylandDisplay::GetInstance()->GetSerial());
+      cursor, WaylandDisplay::GetInstance()->GetSerial());
+}
+
+void WaylandSeat::SetThemeCursor(wl_cursor* cursor, int scale) {
+  if (!input_pointer_) {
+    LOG(WARNING) << "Tried to change cursor without input configured";
+    return;
+  }
+
+  input_pointer_->Cursor()->UpdateThemeCursor(
+      cursor, scale, WaylandDisplay::GetInstance()->GetSerial());
 }
 
 void WaylandSeat::MoveCursor(const gfx::Point& location) {
@@ -10,9 +10,12 @@
 #include <string>
 
 #include "base/macros.h"
+#include "ozone/wayland/input/cursor_cache.h"
 #include "third_party/skia/include/core/SkBitmap.h"
 #include "ui/gfx/geometry/rect.h"
 
+struct wl_cursor;
+
 namespace ozonewayland {
 
 class WaylandDataDevice;
@@ -39,8 +42,9 @@ class WaylandSeat {
   void SetFocusWindowHandle(unsigned windowhandle);
   void SetKeyboardFocusWindowHandle(unsigned windowhandle);
   void SetGrabWindowHandle(unsigned windowhandle, uint32_t button);
-  void SetCursorBitmap(const std::vector<SkBitmap>& bitmaps,
-                       const gfx::Point& location);
+  // Shows |cursor|, or hides the cursor if it is NULL.
+  void SetCursorBitmap(const WaylandCursorCache::Entry* cursor);
+  void SetThemeCursor(wl_cursor* cursor, int scale);
   void MoveCursor(const gfx::Point& location);
 
   void ResetIme();
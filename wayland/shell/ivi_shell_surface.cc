@@ -4,29 +4,101 @@
 
 #include "ozone/wayland/shell/ivi_shell_surface.h"
 
+#include <algorithm>
+#include <map>
+#include <vector>
+
+#include "base/lazy_instance.h"
 #include "base/logging.h"
 #include "base/strings/utf_string_conversions.h"
+#include "base/synchronization/lock.h"
+#include "base/trace_event/trace_event.h"
 
 #include "ozone/wayland/display.h"
 #include "ozone/wayland/protocol/ivi-application-client-protocol.h"
 #include "ozone/wayland/shell/shell.h"
 
 #include "ilm/ilm_common.h"
+#include "ilm/ilm_control.h"
 #include "ilm/ilm_input.h"
 
 #define IVI_SURFACE_ID 7000
 
 namespace ozonewayland {
 
+namespace {
+
+// The surfaces by IVI id and the surfaces on each watched layer, for the ILM
+// notifications. These are delivered on the ILM thread, hence the lock.
+typedef std::map<t_ilm_surface, IVIShellSurface*> SurfaceMap;
+typedef std::map<t_ilm_layer, std::set<t_ilm_surface>> LayerMap;
+base::LazyInstance<SurfaceMap>::Leaky g_surfaces = LAZY_INSTANCE_INITIALIZER;
+base::LazyInstance<LayerMap>::Leaky g_layers = LAZY_INSTANCE_INITIALIZER;
+base::LazyInstance<base::Lock>::Leaky g_surfaces_lock =
+    LAZY_INSTANCE_INITIALIZER;
+
+void NotifySurface(t_ilm_surface surface) {
+  g_surfaces_lock.Get().AssertAcquired();
+  SurfaceMap::iterator it = g_surfaces.Get().find(surface);
+  if (it != g_surfaces.Get().end())
+    it->second->OnIlmNotification();
+}
+
+void OnSurfaceNotification(t_ilm_surface surface,
+                           struct ilmSurfaceProperties* properties,
+                           t_ilm_notification_mask mask) {
+  base::AutoLock lock(g_surfaces_lock.Get());
+  NotifySurface(surface);
+}
+
+void OnLayerNotification(t_ilm_layer layer,
+                         struct ilmLayerProperties* properties,
+                         t_ilm_notification_mask mask) {
+  base::AutoLock lock(g_surfaces_lock.Get());
+  LayerMap::iterator it = g_layers.Get().find(layer);
+  if (it == g_layers.Get().end())
+    return;
+
+  for (t_ilm_surface surface : it->second)
+    NotifySurface(surface);
+}
+
+}  // namespace
+
 int IVIShellSurface::last_ivi_surface_id_ = IVI_SURFACE_ID;
 
 IVIShellSurface::IVIShellSurface()
     : WaylandShellSurface(),
       ivi_surface_(NULL),
-      ivi_surface_id_(IVI_SURFACE_ID) {
+      ivi_surface_id_(IVI_SURFACE_ID),
+      seats_stale_(1),
+      notification_added_(false) {
 }
 
 IVIShellSurface::~IVIShellSurface() {
+  if (notification_added_) {
+    ilm_surfaceRemoveNotification(ivi_surface_id_);
+    std::vector<t_ilm_layer> unwatched_layers;
+    {
+      base::AutoLock lock(g_surfaces_lock.Get());
+      g_surfaces.Get().erase(ivi_surface_id_);
+      for (unsigned layer : watched_layers_) {
+        LayerMap::iterator it = g_layers.Get().find(layer);
+        if (it == g_layers.Get().end())
+          continue;
+
+        it->second.erase(ivi_surface_id_);
+        if (it->second.empty()) {
+          g_layers.Get().erase(it);
+          unwatched_layers.push_back(layer);
+        }
+      }
+    }
+
+    for (t_ilm_layer layer : unwatched_layers)
+      ilm_layerRemoveNotification(layer);
+  }
+
   ivi_surface_destroy(ivi_surface_);
 }
 
@@ -44,6 +116,7 @@ void IVIShellSurface::InitializeShellSurface(WaylandWindow* window,
     ivi_surface_id_ = last_ivi_surface_id_ + 1;
   ivi_surface_ = ivi_application_surface_create(
                      shell->GetIVIShell(), ivi_surface_id_, GetWLSurface());
+  MoveToEventQueue(ivi_surface_);
   last_ivi_surface_id_ = ivi_surface_id_;
 
   DCHECK(ivi_surface_);
@@ -55,6 +128,27 @@ void IVIShellSurface::InitializeShellSurface(WaylandWindow* window,
   if (ret_code != ILM_SUCCESS) {
     error_msg = ILM_ERROR_STRING(ret_code);
     LOG(ERROR) << error_msg;
+    return;
+  }
+
+  // Windows sharing an id (OZONE_WAYLAND_IVI_SURFACE_ID) can't tell whose
+  // notification it is, they rely on the devices entering them.
+  {
+    base::AutoLock lock(g_surfaces_lock.Get());
+    notification_added_ = g_surfaces.Get().insert(
+        std::make_pair(ivi_surface_id_, this)).second;
+  }
+
+  if (!notification_added_)
+    return;
+
+  ret_code = ilm_surfaceAddNotification(ivi_surface_id_,
+                                        OnSurfaceNotification);
+  if (ret_code != ILM_SUCCESS) {
+    LOG(ERROR) << ILM_ERROR_STRING(ret_code);
+    notification_added_ = false;
+    base::AutoLock lock(g_surfaces_lock.Get());
+    g_surfaces.Get().erase(ivi_surface_id_);
   }
 }
 
@@ -62,7 +156,7 @@ void IVIShellSurface::UpdateShellSurface(WaylandWindow::ShellType type,
                                          WaylandShellSurface* shell_parent,
                                          int x,
                                          int y) {
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void IVIShellSurface::SetWindowTitle(const base::string16& title) {
@@ -82,29 +176,131 @@ bool IVIShellSurface::IsMinimized() const {
 }
 
 bool IVIShellSurface::CanAcceptSeatEvents(const char* seat_name) {
+  if (base::subtle::NoBarrier_AtomicExchange(&seats_stale_, 0))
+    UpdateAcceptedSeats();
+
+  if (!accepted_seats_.count(seat_name)) {
+    reported_seats_.erase(seat_name);
+    return false;
+  }
+
+  if (reported_seats_.insert(seat_name).second) {
+    WaylandDisplay::GetInstance()->SeatAssignmentChanged(seat_name,
+                                                         window_handle_);
+  }
+
+  return true;
+}
+
+void IVIShellSurface::InvalidateSeatAcceptance() {
+  if (!notification_added_)
+    base::subtle::NoBarrier_Store(&seats_stale_, 1);
+}
+
+void IVIShellSurface::UpdateSeatAcceptance() {
+  if (!base::subtle::NoBarrier_AtomicExchange(&seats_stale_, 0))
+    return;
+
+  UpdateAcceptedSeats();
+  // A window the devices don't move in and out of, e.g. a single fullscreen
+  // one, only learns about the seats assigned to it from here.
   WaylandDisplay* display = WaylandDisplay::GetInstance();
+  for (const std::string& seat_name : accepted_seats_) {
+    if (reported_seats_.insert(seat_name).second)
+      display->SeatAssignmentChanged(seat_name, window_handle_);
+  }
 
-  t_ilm_uint num_seats;
-  t_ilm_string *seats = NULL;
-  const char* error_msg;
-  bool found = false;
-
-  ilmErrorTypes ret_code = ilm_getInputAcceptanceOn(ivi_surface_id_, &num_seats, &seats);
-  if (ret_code == ILM_SUCCESS) {
-    for (int i = 0; i < num_seats; ++i) {
-      if (strcmp(reinterpret_cast<const char*>(seats[i]), seat_name) == 0) {
-        display->SeatAssignmentChanged(seat_name, window_handle_);
-        found = true;
-      }
-      free(seats[i]);
-    }
+  std::set<std::string>::iterator it = reported_seats_.begin();
+  while (it != reported_seats_.end()) {
+    if (accepted_seats_.count(*it))
+      ++it;
+    else
+      it = reported_seats_.erase(it);
   }
-  else {
-    error_msg = ILM_ERROR_STRING(ret_code);
-    LOG(ERROR) << error_msg;
+}
+
+void IVIShellSurface::OnIlmNotification() {
+  base::subtle::NoBarrier_Store(&seats_stale_, 1);
+  WaylandDisplay::GetInstance()->SeatAcceptanceChanged(window_handle_);
+}
+
+void IVIShellSurface::UpdateAcceptedSeats() {
+  TRACE_EVENT0("ozone", "IVIShellSurface::UpdateAcceptedSeats");
+  accepted_seats_.clear();
+  t_ilm_uint num_seats = 0;
+  t_ilm_string* seats = NULL;
+  ilmErrorTypes ret_code =
+      ilm_getInputAcceptanceOn(ivi_surface_id_, &num_seats, &seats);
+  if (ret_code != ILM_SUCCESS) {
+    LOG(ERROR) << ILM_ERROR_STRING(ret_code);
+    // Try again on the next event.
+    base::subtle::NoBarrier_Store(&seats_stale_, 1);
+    return;
   }
+
+  for (t_ilm_uint i = 0; i < num_seats; ++i) {
+    accepted_seats_.insert(reinterpret_cast<const char*>(seats[i]));
+    free(seats[i]);
+  }
+
   free(seats);
-  return found;
+
+  if (notification_added_)
+    WatchLayers();
+}
+
+void IVIShellSurface::WatchLayers() {
+  t_ilm_int num_layers = 0;
+  t_ilm_layer* layers = NULL;
+  ilmErrorTypes ret_code = ilm_getLayerIDs(&num_layers, &layers);
+  if (ret_code != ILM_SUCCESS) {
+    LOG(ERROR) << ILM_ERROR_STRING(ret_code);
+    return;
+  }
+
+  for (t_ilm_int i = 0; i < num_layers; ++i) {
+    t_ilm_layer layer = layers[i];
+    if (watched_layers_.count(layer))
+      continue;
+
+    t_ilm_int num_surfaces = 0;
+    t_ilm_surface* surfaces = NULL;
+    if (ilm_getSurfaceIDsOnLayer(layer, &num_surfaces, &surfaces) !=
+        ILM_SUCCESS) {
+      continue;
+    }
+
+    bool on_layer = std::find(surfaces, surfaces + num_surfaces,
+                              static_cast<t_ilm_surface>(ivi_surface_id_)) !=
+        surfaces + num_surfaces;
+    free(surfaces);
+    if (!on_layer)
+      continue;
+
+    // Layers are shared by the windows, only the first one adds the
+    // notification.
+    watched_layers_.insert(layer);
+    bool add_notification;
+    {
+      base::AutoLock lock(g_surfaces_lock.Get());
+      std::set<t_ilm_surface>& layer_surfaces = g_layers.Get()[layer];
+      add_notification = layer_surfaces.empty();
+      layer_surfaces.insert(ivi_surface_id_);
+    }
+
+    if (!add_notification)
+      continue;
+
+    ret_code = ilm_layerAddNotification(layer, OnLayerNotification);
+    if (ret_code != ILM_SUCCESS) {
+      // The surface notification still covers most changes.
+      LOG(ERROR) << ILM_ERROR_STRING(ret_code);
+      base::AutoLock lock(g_surfaces_lock.Get());
+      g_layers.Get().erase(layer);
+    }
+  }
+
+  free(layers);
 }
 
 }  // namespace ozonewayland
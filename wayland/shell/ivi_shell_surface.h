@@ -5,6 +5,10 @@
 #ifndef OZONE_WAYLAND_SHELL_IVI_SHELL_SURFACE_H_
 #define OZONE_WAYLAND_SHELL_IVI_SHELL_SURFACE_H_
 
+#include <set>
+#include <string>
+
+#include "base/atomicops.h"
 #include "ozone/wayland/shell/shell_surface.h"
 
 struct ivi_surface;
@@ -31,12 +35,35 @@ class IVIShellSurface : public WaylandShellSurface {
   void Unminimize() override;
   bool IsMinimized() const override;
   bool CanAcceptSeatEvents(const char* seat_name) override;
+  void InvalidateSeatAcceptance() override;
+  void UpdateSeatAcceptance() override;
+
+  // Called on the ILM thread when the surface or one of its layers changed.
+  void OnIlmNotification();
 
  private:
+  // Queries ILM for the seats the surface accepts events from. This is a
+  // round trip to the layer manager, so it is only done after a change.
+  void UpdateAcceptedSeats();
+  // Asks ILM to notify the changes of the layers showing the surface, which
+  // may only be known once the surface has been shown.
+  void WatchLayers();
+
   ivi_surface* ivi_surface_;
   int ivi_surface_id_;
   static int last_ivi_surface_id_;
   unsigned window_handle_;
+  // Only accessed on the input thread.
+  std::set<std::string> accepted_seats_;
+  // Seats the browser was told about with SeatAssignmentChanged.
+  std::set<std::string> reported_seats_;
+  // Set when |accepted_seats_| needs to be queried again.
+  base::subtle::Atomic32 seats_stale_;
+  // Whether ILM notifies the changes of the surface. Otherwise the seats are
+  // queried again whenever a device enters the window after another one.
+  bool notification_added_;
+  // The IVI ids of the layers ILM notifies the changes of.
+  std::set<unsigned> watched_layers_;
   DISALLOW_COPY_AND_ASSIGN(IVIShellSurface);
 };
 
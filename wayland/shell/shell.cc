@@ -44,9 +44,10 @@ WaylandShell::CreateShellSurface(WaylandWindow* window,
     surface = new WLShellSurface();
 
   DCHECK(surface);
+  surface->SetEventQueue(window->event_queue());
   surface->InitializeShellSurface(window, type);
   wl_surface_set_user_data(surface->GetWLSurface(), window);
-  display->FlushDisplay();
+  display->ScheduleFlush();
 
   return surface;
 }
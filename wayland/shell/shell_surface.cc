@@ -10,7 +10,8 @@
 namespace ozonewayland {
 
 WaylandShellSurface::WaylandShellSurface()
-    : surface_(NULL) {
+    : surface_(NULL),
+      queue_(NULL) {
   WaylandDisplay* display = WaylandDisplay::GetInstance();
   surface_ = wl_compositor_create_surface(display->GetCompositor());
 }
@@ -18,17 +19,27 @@ WaylandShellSurface::WaylandShellSurface()
 WaylandShellSurface::~WaylandShellSurface() {
   DCHECK(surface_);
   wl_surface_destroy(surface_);
-  FlushDisplay();
+  ScheduleFlush();
 }
 
 struct wl_surface* WaylandShellSurface::GetWLSurface() const {
     return surface_;
 }
 
-void WaylandShellSurface::FlushDisplay() const {
+void WaylandShellSurface::SetEventQueue(wl_event_queue* queue) {
+  queue_ = queue;
+  MoveToEventQueue(surface_);
+}
+
+void WaylandShellSurface::MoveToEventQueue(void* proxy) const {
+  if (queue_)
+    wl_proxy_set_queue(static_cast<wl_proxy*>(proxy), queue_);
+}
+
+void WaylandShellSurface::ScheduleFlush() const {
   WaylandDisplay* display = WaylandDisplay::GetInstance();
   DCHECK(display);
-  display->FlushDisplay();
+  display->ScheduleFlush();
 }
 
 void WaylandShellSurface::PopupDone() {
@@ -45,7 +56,7 @@ void WaylandShellSurface::WindowResized(void* data,
                                  unsigned width,
                                  unsigned height) {
   WaylandWindow *window = static_cast<WaylandWindow*>(data);
-  WaylandDisplay::GetInstance()->WindowResized(window->Handle(), width, height);
+  window->OnConfigure(width, height);
 }
 
 void WaylandShellSurface::WindowActivated(void *data) {
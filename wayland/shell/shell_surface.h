@@ -21,6 +21,11 @@ class WaylandShellSurface {
 
   struct wl_surface* GetWLSurface() const;
 
+  // Moves the surface to |queue|. The shell objects created afterwards by
+  // InitializeShellSurface and UpdateShellSurface are moved there too, so all
+  // the events of the window are dispatched by the thread owning |queue|.
+  void SetEventQueue(wl_event_queue* queue);
+
   // The implementation should initialize the shell and set up all
   // necessary callbacks.
   virtual void InitializeShellSurface(WaylandWindow* window,
@@ -35,6 +40,16 @@ class WaylandShellSurface {
   virtual void Unminimize() = 0;
   virtual bool IsMinimized() const = 0;
   virtual bool CanAcceptSeatEvents(const char* seat_name) = 0;
+  // The seats the window accepts events from may have changed, because a seat
+  // focused it after focusing another window.
+  virtual void InvalidateSeatAcceptance() {}
+  // Tells the browser about the seats the window started accepting events
+  // from since they last changed. Called on the input thread.
+  virtual void UpdateSeatAcceptance() {}
+  // Acknowledges the last configure request the window hasn't adapted to
+  // yet. Called right before the window starts drawing at its new size, so
+  // that the next commit matches the acknowledged state.
+  virtual void AckPendingConfigure() {}
 
   // static functions.
   static void PopupDone();
@@ -43,10 +58,13 @@ class WaylandShellSurface {
   static void WindowDeActivated(void *data);
 
  protected:
-  void FlushDisplay() const;
+  void ScheduleFlush() const;
+  // Moves |proxy| to the queue set by SetEventQueue, if any.
+  void MoveToEventQueue(void* proxy) const;
 
  private:
   struct wl_surface* surface_;
+  wl_event_queue* queue_;
   DISALLOW_COPY_AND_ASSIGN(WaylandShellSurface);
 };
 
@@ -31,6 +31,7 @@ void WLShellSurface::InitializeShellSurface(WaylandWindow* window,
   DCHECK(shell && shell->GetWLShell());
   shell_surface_ = wl_shell_get_shell_surface(shell->GetWLShell(),
                                               GetWLSurface());
+  MoveToEventQueue(shell_surface_);
 
   static const wl_shell_surface_listener shell_surface_listener = {
     WLShellSurface::HandlePing,
@@ -79,17 +80,17 @@ void WLShellSurface::UpdateShellSurface(WaylandWindow::ShellType type,
       break;
   }
 
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void WLShellSurface::SetWindowTitle(const base::string16& title) {
   wl_shell_surface_set_title(shell_surface_, UTF16ToUTF8(title).c_str());
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void WLShellSurface::Maximize() {
   wl_shell_surface_set_maximized(shell_surface_, NULL);
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void WLShellSurface::Minimize() {
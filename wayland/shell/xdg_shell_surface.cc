@@ -18,6 +18,7 @@ XDGShellSurface::XDGShellSurface()
     : WaylandShellSurface(),
       xdg_surface_(NULL),
       xdg_popup_(NULL),
+      pending_configure_serial_(0),
       maximized_(false),
       minimized_(false) {
 }
@@ -41,6 +42,7 @@ void XDGShellSurface::InitializeShellSurface(WaylandWindow* window,
   if (type != WaylandWindow::POPUP) {
     xdg_surface_ = xdg_shell_get_xdg_surface(shell->GetXDGShell(),
                                              GetWLSurface());
+    MoveToEventQueue(xdg_surface_);
 
     static const xdg_surface_listener xdg_surface_listener = {
       XDGShellSurface::HandleConfigure,
@@ -80,6 +82,7 @@ void XDGShellSurface::UpdateShellSurface(WaylandWindow::ShellType type,
                                          x,
                                          y,
                                          0);
+    MoveToEventQueue(xdg_popup_);
     static const xdg_popup_listener xdg_popup_listener = {
       XDGShellSurface::HandlePopupPopupDone
     };
@@ -100,18 +103,18 @@ void XDGShellSurface::UpdateShellSurface(WaylandWindow::ShellType type,
       break;
   }
 
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void XDGShellSurface::SetWindowTitle(const base::string16& title) {
   xdg_surface_set_title(xdg_surface_, UTF16ToUTF8(title).c_str());
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void XDGShellSurface::Maximize() {
   xdg_surface_set_maximized(xdg_surface_);
   maximized_ = true;
-  WaylandShellSurface::FlushDisplay();
+  WaylandShellSurface::ScheduleFlush();
 }
 
 void XDGShellSurface::Minimize() {
@@ -130,6 +133,15 @@ bool XDGShellSurface::IsMinimized() const {
 bool XDGShellSurface::CanAcceptSeatEvents(const char* seat_name) {
   return true;
 }
+
+void XDGShellSurface::AckPendingConfigure() {
+  if (!pending_configure_serial_)
+    return;
+
+  // Acknowledging the latest serial acknowledges all the previous ones too.
+  xdg_surface_ack_configure(xdg_surface_, pending_configure_serial_);
+  pending_configure_serial_ = 0;
+}
   
 void XDGShellSurface::HandleConfigure(void* data,
                                       struct xdg_surface* xdg_surface,
@@ -146,10 +158,22 @@ void XDGShellSurface::HandleConfigure(void* data,
   if (!states->size)
     WaylandShellSurface::WindowDeActivated(data);
 
-  if ((width > 0) && (height > 0))
-    WaylandShellSurface::WindowResized(data, width, height);
+  WaylandWindow* window = static_cast<WaylandWindow*>(data);
+  XDGShellSurface* shell_surface =
+      static_cast<XDGShellSurface*>(window->ShellSurface());
+  gfx::Size size = window->GetBounds().size();
+  if ((width <= 0) || (height <= 0) ||
+      ((width == size.width()) && (height == size.height()))) {
+    // Nothing to redraw, the current content already matches.
+    shell_surface->pending_configure_serial_ = 0;
+    xdg_surface_ack_configure(xdg_surface, serial);
+    return;
+  }
 
-  xdg_surface_ack_configure(xdg_surface, serial);
+  // The acknowledgement is sent once the window resizes its buffers, see
+  // AckPendingConfigure, and the size is forwarded once per dispatch cycle.
+  shell_surface->pending_configure_serial_ = serial;
+  WaylandShellSurface::WindowResized(data, width, height);
 }
 
 void XDGShellSurface::HandleDelete(void* data,
@@ -32,6 +32,7 @@ class XDGShellSurface : public WaylandShellSurface {
   void Unminimize() override;
   bool IsMinimized() const override;
   bool CanAcceptSeatEvents(const char* seat_name) override;
+  void AckPendingConfigure() override;
 
   static void HandleConfigure(void* data,
                               struct xdg_surface* xdg_surface,
@@ -49,6 +50,8 @@ class XDGShellSurface : public WaylandShellSurface {
  private:
   xdg_surface* xdg_surface_;
   xdg_popup* xdg_popup_;
+  // Serial of the last configure waiting for a frame at its size, 0 if none.
+  uint32_t pending_configure_serial_;
   bool maximized_;
   bool minimized_;
   DISALLOW_COPY_AND_ASSIGN(XDGShellSurface);
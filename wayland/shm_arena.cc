@@ -0,0 +1,332 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/shm_arena.h"
+
+#include <stdio.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_file.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/display.h"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+namespace ozonewayland {
+
+namespace {
+
+const size_t kInitialSize = 1 << 20;
+// Address space reserved for the arena. Only the part in use is backed by
+// memory.
+const size_t kReservedSize = sizeof(void*) == 8 ? 1 << 30 : 256 << 20;
+const int kBytesPerPixel = 4;
+
+size_t RoundUpToPageSize(size_t size) {
+  size_t page_size = static_cast<size_t>(getpagesize());
+  return (size + page_size - 1) / page_size * page_size;
+}
+
+int CreateAnonymousFile() {
+#if defined(__NR_memfd_create)
+  int fd = syscall(__NR_memfd_create, "ozone-wayland-shm", MFD_CLOEXEC);
+  if (fd >= 0)
+    return fd;
+#endif
+
+  // Kernels older than 3.17.
+  base::FilePath path;
+  base::ScopedFILE file(base::CreateAndOpenTemporaryShmemFile(&path, false));
+  if (!file)
+    return -1;
+
+  base::DeleteFile(path, false);
+  return HANDLE_EINTR(dup(fileno(file.get())));
+}
+
+}  // namespace
+
+WaylandShmBuffer::WaylandShmBuffer()
+    : arena_(NULL),
+      buffer_(NULL),
+      memory_(NULL),
+      stride_(0),
+      offset_(0),
+      block_size_(0),
+      busy_(false),
+      orphaned_(false) {
+}
+
+WaylandShmBuffer::~WaylandShmBuffer() {
+  if (buffer_)
+    wl_buffer_destroy(buffer_);
+}
+
+WaylandShmArena::WaylandShmArena()
+    : fd_(-1),
+      base_(NULL),
+      mapped_size_(0),
+      used_size_(0),
+      pool_(NULL),
+      allocation_count_(0),
+      reuse_count_(0),
+      allocated_bytes_(0) {
+}
+
+WaylandShmArena::~WaylandShmArena() {
+  for (WaylandShmBuffer* buffer : buffers_)
+    delete buffer;
+
+  buffers_.clear();
+  if (pool_)
+    wl_shm_pool_destroy(pool_);
+
+  if (base_)
+    munmap(base_, kReservedSize);
+
+  if (fd_ >= 0)
+    close(fd_);
+}
+
+bool WaylandShmArena::Initialize() {
+  DCHECK_LT(fd_, 0);
+  fd_ = CreateAnonymousFile();
+  if (fd_ < 0) {
+    LOG(ERROR) << "Failed to create the shm arena file";
+    return false;
+  }
+
+  void* base = mmap(NULL, kReservedSize, PROT_NONE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (base == MAP_FAILED) {
+    LOG(ERROR) << "Failed to reserve " << kReservedSize
+               << " bytes for the shm arena";
+    close(fd_);
+    fd_ = -1;
+    return false;
+  }
+
+  base_ = static_cast<uint8_t*>(base);
+  base::AutoLock lock(lock_);
+  return Grow(kInitialSize);
+}
+
+WaylandShmBuffer* WaylandShmArena::CreateBuffer(const gfx::Size& size,
+                                                uint32_t format,
+                                                wl_event_queue* queue) {
+  DCHECK(format == WL_SHM_FORMAT_ARGB8888 || format == WL_SHM_FORMAT_XRGB8888);
+  wl_shm* shm = WaylandDisplay::GetInstance()->GetShm();
+  if (!base_ || !shm || size.IsEmpty())
+    return NULL;
+
+  static const struct wl_buffer_listener buffer_listener = {
+    WaylandShmArena::OnBufferRelease
+  };
+
+  base::AutoLock lock(lock_);
+  int stride = size.width() * kBytesPerPixel;
+  size_t offset, block_size;
+  if (!AllocateBlock(static_cast<size_t>(stride) * size.height(),
+                     &offset, &block_size)) {
+    LOG(ERROR) << "The shm arena has no room for a " << size.ToString()
+               << " buffer";
+    return NULL;
+  }
+
+  if (!pool_)
+    pool_ = wl_shm_create_pool(shm, fd_, mapped_size_);
+
+  WaylandShmBuffer* buffer = new WaylandShmBuffer();
+  buffer->arena_ = this;
+  buffer->memory_ = base_ + offset;
+  buffer->size_ = size;
+  buffer->stride_ = stride;
+  buffer->offset_ = offset;
+  buffer->block_size_ = block_size;
+  buffer->buffer_ = wl_shm_pool_create_buffer(pool_, offset,
+                                              size.width(), size.height(),
+                                              stride, format);
+  if (queue)
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(buffer->buffer_), queue);
+
+  wl_buffer_add_listener(buffer->buffer_, &buffer_listener, buffer);
+  buffers_.insert(buffer);
+  allocated_bytes_ += block_size;
+  UpdateCounters();
+  return buffer;
+}
+
+void WaylandShmArena::DestroyBuffer(WaylandShmBuffer* buffer) {
+  if (!buffer)
+    return;
+
+  base::AutoLock lock(lock_);
+  DCHECK(buffers_.count(buffer));
+  if (buffer->busy_) {
+    // The queue the release was meant for may be destroyed along with the
+    // owner of the buffer.
+    wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(buffer->buffer_), NULL);
+    buffer->orphaned_ = true;
+    return;
+  }
+
+  ReleaseBuffer(buffer);
+}
+
+void WaylandShmArena::Attach(WaylandShmBuffer* buffer,
+                             wl_surface* surface,
+                             int x,
+                             int y) {
+  base::AutoLock lock(lock_);
+  buffer->busy_ = true;
+  wl_surface_attach(surface, buffer->buffer_, x, y);
+}
+
+bool WaylandShmArena::IsBusy(const WaylandShmBuffer* buffer) {
+  base::AutoLock lock(lock_);
+  return buffer->busy_;
+}
+
+bool WaylandShmArena::AllocateBlock(size_t size,
+                                    size_t* offset,
+                                    size_t* block_size) {
+  lock_.AssertAcquired();
+  size = RoundUpToPageSize(size);
+  std::multimap<size_t, size_t>::iterator it = free_blocks_.lower_bound(size);
+  if (it != free_blocks_.end()) {
+    size_t free_size = it->first;
+    *offset = it->second;
+    *block_size = size;
+    RemoveFreeBlock(*offset, free_size);
+    if (free_size > size)
+      FreeBlock(*offset + size, free_size - size);
+
+    reuse_count_++;
+    return true;
+  }
+
+  if (used_size_ + size > mapped_size_ && !Grow(used_size_ + size))
+    return false;
+
+  *offset = used_size_;
+  *block_size = size;
+  used_size_ += size;
+  allocation_count_++;
+  return true;
+}
+
+void WaylandShmArena::FreeBlock(size_t offset, size_t block_size) {
+  lock_.AssertAcquired();
+  std::map<size_t, size_t>::iterator next =
+      free_blocks_by_offset_.lower_bound(offset);
+  if (next != free_blocks_by_offset_.end() &&
+      next->first == offset + block_size) {
+    size_t next_size = next->second;
+    RemoveFreeBlock(next->first, next_size);
+    block_size += next_size;
+  }
+
+  std::map<size_t, size_t>::iterator prev =
+      free_blocks_by_offset_.lower_bound(offset);
+  if (prev != free_blocks_by_offset_.begin()) {
+    --prev;
+    if (prev->first + prev->second == offset) {
+      size_t prev_offset = prev->first;
+      size_t prev_size = prev->second;
+      RemoveFreeBlock(prev_offset, prev_size);
+      offset = prev_offset;
+      block_size += prev_size;
+    }
+  }
+
+  // Blocks at the end go back to the unused part of the arena.
+  if (offset + block_size == used_size_) {
+    used_size_ = offset;
+    return;
+  }
+
+  free_blocks_.insert(std::make_pair(block_size, offset));
+  free_blocks_by_offset_[offset] = block_size;
+}
+
+void WaylandShmArena::RemoveFreeBlock(size_t offset, size_t block_size) {
+  std::pair<std::multimap<size_t, size_t>::iterator,
+            std::multimap<size_t, size_t>::iterator> range =
+      free_blocks_.equal_range(block_size);
+  for (std::multimap<size_t, size_t>::iterator it = range.first;
+       it != range.second; ++it) {
+    if (it->second == offset) {
+      free_blocks_.erase(it);
+      break;
+    }
+  }
+
+  free_blocks_by_offset_.erase(offset);
+}
+
+bool WaylandShmArena::Grow(size_t min_size) {
+  lock_.AssertAcquired();
+  size_t new_size = RoundUpToPageSize(std::max(min_size, mapped_size_ * 2));
+  new_size = std::min(new_size, kReservedSize);
+  if (new_size < min_size)
+    return false;
+
+  if (HANDLE_EINTR(ftruncate(fd_, new_size)) < 0) {
+    LOG(ERROR) << "Failed to grow the shm arena to " << new_size << " bytes";
+    return false;
+  }
+
+  // Only the new part is mapped, the buffers handed out stay where they are.
+  void* memory = mmap(base_ + mapped_size_, new_size - mapped_size_,
+                      PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                      fd_, mapped_size_);
+  if (memory == MAP_FAILED) {
+    LOG(ERROR) << "Failed to map the shm arena";
+    return false;
+  }
+
+  mapped_size_ = new_size;
+  if (pool_)
+    wl_shm_pool_resize(pool_, mapped_size_);
+
+  UpdateCounters();
+  return true;
+}
+
+void WaylandShmArena::ReleaseBuffer(WaylandShmBuffer* buffer) {
+  lock_.AssertAcquired();
+  FreeBlock(buffer->offset_, buffer->block_size_);
+  allocated_bytes_ -= buffer->block_size_;
+  buffers_.erase(buffer);
+  delete buffer;
+  UpdateCounters();
+}
+
+void WaylandShmArena::UpdateCounters() {
+  TRACE_COUNTER_ID2("ozone", "WaylandShmArena", this,
+                    "resident_bytes", mapped_size_,
+                    "allocated_bytes", allocated_bytes_);
+}
+
+// static
+void WaylandShmArena::OnBufferRelease(void* data, wl_buffer* buffer) {
+  WaylandShmBuffer* shm_buffer = static_cast<WaylandShmBuffer*>(data);
+  WaylandShmArena* arena = shm_buffer->arena_;
+  base::AutoLock lock(arena->lock_);
+  shm_buffer->busy_ = false;
+  if (shm_buffer->orphaned_)
+    arena->ReleaseBuffer(shm_buffer);
+}
+
+}  // namespace ozonewayland
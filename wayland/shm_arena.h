@@ -0,0 +1,121 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_SHM_ARENA_H_
+#define OZONE_WAYLAND_SHM_ARENA_H_
+
+#include <wayland-client.h>
+
+#include <map>
+#include <set>
+
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace ozonewayland {
+
+class WaylandShmArena;
+
+// A wl_buffer sub-allocated from a WaylandShmArena.
+class WaylandShmBuffer {
+ public:
+  wl_buffer* buffer() const { return buffer_; }
+  void* memory() const { return memory_; }
+  const gfx::Size& size() const { return size_; }
+  int stride() const { return stride_; }
+
+ private:
+  friend class WaylandShmArena;
+
+  WaylandShmBuffer();
+  ~WaylandShmBuffer();
+
+  WaylandShmArena* arena_;
+  wl_buffer* buffer_;
+  void* memory_;
+  gfx::Size size_;
+  int stride_;
+  size_t offset_;
+  size_t block_size_;
+  // Set from Attach until wl_buffer.release.
+  bool busy_;
+  // Set by DestroyBuffer while busy, the block is recycled on release.
+  bool orphaned_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandShmBuffer);
+};
+
+// Shared memory for all the wl_shm clients (cursor, software canvas). The
+// buffers are carved out of a single memfd shared with the compositor through
+// one wl_shm_pool, which is grown as needed. Freed blocks are kept in a free
+// list ordered by size and handed out again before the pool grows; blocks of
+// buffers the compositor still holds are only recycled once it releases them.
+// The arena is thread safe, release events may be dispatched on any queue.
+class WaylandShmArena {
+ public:
+  WaylandShmArena();
+  ~WaylandShmArena();
+
+  // Creates the memfd and reserves address space for it. This has to happen
+  // before the sandbox is engaged.
+  bool Initialize();
+
+  // Returns a buffer of |size| pixels in |format| (a wl_shm_format) or NULL
+  // on failure. Its release events are delivered on |queue|, or on the
+  // default queue if NULL.
+  WaylandShmBuffer* CreateBuffer(const gfx::Size& size,
+                                 uint32_t format,
+                                 wl_event_queue* queue);
+  // Gives |buffer| back to the arena. Its memory is reused as soon as the
+  // compositor doesn't hold it anymore. The release of a busy buffer is then
+  // delivered on the default queue, releases already queued elsewhere must
+  // still be dispatched.
+  void DestroyBuffer(WaylandShmBuffer* buffer);
+  // Attaches |buffer| to |surface|, it is busy until the compositor releases
+  // it.
+  void Attach(WaylandShmBuffer* buffer, wl_surface* surface, int x, int y);
+  bool IsBusy(const WaylandShmBuffer* buffer);
+
+  // Number of blocks carved out of the memfd so far, reused blocks excluded.
+  size_t allocation_count() const { return allocation_count_; }
+  // Number of CreateBuffer calls served from the free list.
+  size_t reuse_count() const { return reuse_count_; }
+  // Size of the memfd.
+  size_t resident_bytes() const { return mapped_size_; }
+  // Bytes in use by buffers, including the freed ones still held by the
+  // compositor.
+  size_t allocated_bytes() const { return allocated_bytes_; }
+
+ private:
+  bool AllocateBlock(size_t size, size_t* offset, size_t* block_size);
+  // Returns a block to the free list, merged with its free neighbours.
+  void FreeBlock(size_t offset, size_t block_size);
+  void RemoveFreeBlock(size_t offset, size_t block_size);
+  bool Grow(size_t min_size);
+  void ReleaseBuffer(WaylandShmBuffer* buffer);
+  void UpdateCounters();
+  static void OnBufferRelease(void* data, wl_buffer* buffer);
+
+  int fd_;
+  // Start of the address range reserved for the mapping of |fd_|, so that the
+  // buffers don't move when it grows.
+  uint8_t* base_;
+  size_t mapped_size_;
+  // End of the blocks carved out so far.
+  size_t used_size_;
+  wl_shm_pool* pool_;
+  // Free blocks by size for best fit lookups, and by offset for merging.
+  std::multimap<size_t, size_t> free_blocks_;
+  std::map<size_t, size_t> free_blocks_by_offset_;
+  std::set<WaylandShmBuffer*> buffers_;
+  size_t allocation_count_;
+  size_t reuse_count_;
+  size_t allocated_bytes_;
+  base::Lock lock_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandShmArena);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_SHM_ARENA_H_
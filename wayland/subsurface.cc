@@ -0,0 +1,66 @@
+// Copyright 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/subsurface.h"
+
+#include <limits>
+
+#include "base/logging.h"
+#include "ozone/wayland/display.h"
+
+namespace ozonewayland {
+
+WaylandSubsurface::WaylandSubsurface(wl_surface* parent)
+    : surface_(NULL),
+      subsurface_(NULL),
+      visible_(false) {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  DCHECK(display->GetSubcompositor());
+  surface_ = wl_compositor_create_surface(display->GetCompositor());
+  subsurface_ = wl_subcompositor_get_subsurface(display->GetSubcompositor(),
+                                                surface_,
+                                                parent);
+
+  // Input goes to the window surface below.
+  wl_region* region = wl_compositor_create_region(display->GetCompositor());
+  wl_surface_set_input_region(surface_, region);
+  wl_region_destroy(region);
+}
+
+WaylandSubsurface::~WaylandSubsurface() {
+  wl_subsurface_destroy(subsurface_);
+  wl_surface_destroy(surface_);
+}
+
+void WaylandSubsurface::PlaceAbove(wl_surface* sibling) {
+  wl_subsurface_place_above(subsurface_, sibling);
+}
+
+void WaylandSubsurface::PlaceBelow(wl_surface* sibling) {
+  wl_subsurface_place_below(subsurface_, sibling);
+}
+
+void WaylandSubsurface::Attach(wl_buffer* buffer, const gfx::Point& position) {
+  if (position != position_) {
+    position_ = position;
+    wl_subsurface_set_position(subsurface_, position_.x(), position_.y());
+  }
+
+  wl_surface_attach(surface_, buffer, 0, 0);
+  wl_surface_damage(surface_,
+                    0,
+                    0,
+                    std::numeric_limits<int32_t>::max(),
+                    std::numeric_limits<int32_t>::max());
+  wl_surface_commit(surface_);
+  visible_ = true;
+}
+
+void WaylandSubsurface::Hide() {
+  wl_surface_attach(surface_, NULL, 0, 0);
+  wl_surface_commit(surface_);
+  visible_ = false;
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,45 @@
+// Copyright 2014 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_SUBSURFACE_H_
+#define OZONE_WAYLAND_SUBSURFACE_H_
+
+#include <wayland-client.h>
+
+#include "base/macros.h"
+#include "ui/gfx/geometry/point.h"
+
+namespace ozonewayland {
+
+// WaylandSubsurface shows a buffer on top of (or below) a parent surface,
+// without going through the GPU composition of the parent. The subsurface is
+// synchronized: its state is applied together with the next commit of the
+// parent, so overlays and the window content always update in the same frame.
+class WaylandSubsurface {
+ public:
+  explicit WaylandSubsurface(wl_surface* parent);
+  ~WaylandSubsurface();
+
+  wl_surface* GetWLSurface() const { return surface_; }
+  bool visible() const { return visible_; }
+
+  void PlaceAbove(wl_surface* sibling);
+  void PlaceBelow(wl_surface* sibling);
+
+  // Shows the whole of |buffer|, unscaled, at |position| in the coordinates
+  // of the parent surface.
+  void Attach(wl_buffer* buffer, const gfx::Point& position);
+  void Hide();
+
+ private:
+  wl_surface* surface_;
+  wl_subsurface* subsurface_;
+  gfx::Point position_;
+  bool visible_;
+  DISALLOW_COPY_AND_ASSIGN(WaylandSubsurface);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_SUBSURFACE_H_
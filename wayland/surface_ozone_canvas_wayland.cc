@@ -0,0 +1,243 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/surface_ozone_canvas_wayland.h"
+
+#include <string.h>
+#include <wayland-client.h>
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/logging.h"
+#include "base/time/time.h"
+#include "base/trace_event/trace_event.h"
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/egl/vsync_provider_wayland.h"
+#include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/shm_arena.h"
+#include "ozone/wayland/window.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/vsync_provider.h"
+
+namespace ozonewayland {
+
+namespace {
+
+const size_t kMaxBuffers = 3;
+const int kBytesPerPixel = 4;
+// Longest GetFreeBuffer() waits for the compositor to release a buffer.
+const int kBufferTimeoutMs = 100;
+
+}  // namespace
+
+SurfaceOzoneCanvasWayland::ShmBuffer::ShmBuffer()
+    : shm(NULL) {
+}
+
+SurfaceOzoneCanvasWayland::ShmBuffer::~ShmBuffer() {
+  // The arena keeps the memory of a busy buffer until it is released.
+  WaylandDisplay::GetInstance()->GetShmArena()->DestroyBuffer(shm);
+}
+
+SurfaceOzoneCanvasWayland::SurfaceOzoneCanvasWayland(unsigned handle,
+                                                     bool owns_window)
+    : handle_(handle),
+      owns_window_(owns_window),
+      stride_(0),
+      back_buffer_(NULL),
+      front_buffer_(NULL) {
+}
+
+SurfaceOzoneCanvasWayland::~SurfaceOzoneCanvasWayland() {
+  DestroyBuffers();
+  if (!owns_window_)
+    return;
+
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  // Releases already read into the window queue would be lost with it.
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (window) {
+    wl_display_dispatch_queue_pending(display->display(),
+                                      window->event_queue());
+  }
+
+  display->DestroyWindow(handle_);
+  display->ScheduleFlush();
+}
+
+sk_sp<SkSurface> SurfaceOzoneCanvasWayland::GetSurface() {
+  if (!back_buffer_) {
+    back_buffer_ = GetFreeBuffer();
+    if (!back_buffer_)
+      return nullptr;
+
+    CopyStaleRegion(back_buffer_);
+  }
+
+  return back_buffer_->surface;
+}
+
+void SurfaceOzoneCanvasWayland::ResizeCanvas(const gfx::Size& viewport_size) {
+  if (size_ == viewport_size)
+    return;
+
+  DestroyBuffers();
+  size_ = viewport_size;
+  stride_ = size_.width() * kBytesPerPixel;
+
+  WaylandWindow* window = WaylandDisplay::GetInstance()->GetWindow(handle_);
+  if (!window)
+    return;
+
+  // The buffers are always the size of the window, there is no viewport to
+  // scale a smaller frame back up.
+  window->SetRenderScalePolicy(nullptr);
+  window->Resize(size_.width(), size_.height());
+}
+
+void SurfaceOzoneCanvasWayland::PresentCanvas(const gfx::Rect& damage) {
+  ShmBuffer* buffer = back_buffer_;
+  back_buffer_ = NULL;
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (!buffer || !window)
+    return;
+
+  if (!window->ShellSurface()) {
+    LOG(ERROR) << "Shell type not set. Setting it to TopLevel";
+    window->SetShellAttributes(WaylandWindow::TOPLEVEL);
+  }
+
+  gfx::Rect damaged_rect = gfx::IntersectRects(damage, gfx::Rect(size_));
+  TRACE_EVENT2("ozone", "SurfaceOzoneCanvasWayland::PresentCanvas",
+               "width", damaged_rect.width(),
+               "height", damaged_rect.height());
+  SkIRect rect = SkIRect::MakeXYWH(damaged_rect.x(), damaged_rect.y(),
+                                   damaged_rect.width(),
+                                   damaged_rect.height());
+  for (const auto& other : buffers_) {
+    if (other.get() != buffer)
+      other->stale.op(rect, SkRegion::kUnion_Op);
+  }
+
+  wl_surface* surface = window->ShellSurface()->GetWLSurface();
+  display->GetShmArena()->Attach(buffer->shm, surface, 0, 0);
+  wl_surface_damage(surface, damaged_rect.x(), damaged_rect.y(),
+                    damaged_rect.width(), damaged_rect.height());
+  front_buffer_ = buffer;
+
+  // The frame callback goes with the commit.
+  window->PrepareFrame();
+  wl_surface_commit(surface);
+  window->DidCommitFrame(base::Closure());
+  window->ThrottleFrames();
+  display->OnFrameSwapped();
+}
+
+std::unique_ptr<gfx::VSyncProvider>
+SurfaceOzoneCanvasWayland::CreateVSyncProvider() {
+  return std::unique_ptr<gfx::VSyncProvider>(
+      new WaylandVSyncProvider(handle_));
+}
+
+SurfaceOzoneCanvasWayland::ShmBuffer*
+SurfaceOzoneCanvasWayland::CreateBuffer() {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (!window || size_.IsEmpty())
+    return NULL;
+
+  std::unique_ptr<ShmBuffer> buffer(new ShmBuffer());
+  // Releases are handled along with the frame callbacks of the window.
+  buffer->shm = display->GetShmArena()->CreateBuffer(size_,
+                                                     WL_SHM_FORMAT_ARGB8888,
+                                                     window->event_queue());
+  if (!buffer->shm)
+    return NULL;
+
+  SkImageInfo info = SkImageInfo::MakeN32Premul(size_.width(),
+                                                size_.height());
+  buffer->surface = SkSurface::MakeRasterDirect(info,
+                                                buffer->shm->memory(),
+                                                buffer->shm->stride());
+  buffer->stale.setRect(0, 0, size_.width(), size_.height());
+  buffers_.push_back(std::move(buffer));
+  TRACE_COUNTER_ID1("ozone", "SurfaceOzoneCanvasWayland::Buffers", handle_,
+                    buffers_.size());
+  return buffers_.back().get();
+}
+
+void SurfaceOzoneCanvasWayland::DestroyBuffers() {
+  // The compositor keeps the contents of busy buffers around on its own.
+  buffers_.clear();
+  back_buffer_ = NULL;
+  front_buffer_ = NULL;
+}
+
+SurfaceOzoneCanvasWayland::ShmBuffer*
+SurfaceOzoneCanvasWayland::GetFreeBuffer() {
+  ShmBuffer* free_buffer = GetIdleBuffer();
+  if (free_buffer)
+    return free_buffer;
+
+  if (buffers_.size() < kMaxBuffers)
+    return CreateBuffer();
+
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  WaylandWindow* window = display->GetWindow(handle_);
+  if (!window)
+    return NULL;
+
+  TRACE_EVENT0("ozone", "SurfaceOzoneCanvasWayland::WaitForBuffer");
+  display->FlushDisplay();
+  base::TimeTicks deadline = base::TimeTicks::Now() +
+      base::TimeDelta::FromMilliseconds(kBufferTimeoutMs);
+  while (window->WaitForEvents(deadline)) {
+    free_buffer = GetIdleBuffer();
+    if (free_buffer)
+      return free_buffer;
+  }
+
+  // The compositor may keep the buffers of a hidden window. Draw into one it
+  // still holds rather than blocking the GPU process, at worst it tears.
+  for (const auto& buffer : buffers_) {
+    if (buffer.get() != front_buffer_)
+      return buffer.get();
+  }
+
+  return NULL;
+}
+
+void SurfaceOzoneCanvasWayland::CopyStaleRegion(ShmBuffer* buffer) {
+  if (front_buffer_ && front_buffer_ != buffer && !buffer->stale.isEmpty()) {
+    TRACE_EVENT0("ozone", "SurfaceOzoneCanvasWayland::CopyStaleRegion");
+    const uint8_t* src =
+        static_cast<const uint8_t*>(front_buffer_->shm->memory());
+    uint8_t* dst = static_cast<uint8_t*>(buffer->shm->memory());
+    for (SkRegion::Iterator it(buffer->stale); !it.done(); it.next()) {
+      const SkIRect& rect = it.rect();
+      size_t offset = static_cast<size_t>(rect.y()) * stride_ +
+                      rect.x() * kBytesPerPixel;
+      size_t bytes = rect.width() * kBytesPerPixel;
+      for (int y = rect.top(); y < rect.bottom(); ++y, offset += stride_)
+        memcpy(dst + offset, src + offset, bytes);
+    }
+  }
+
+  buffer->stale.setEmpty();
+}
+
+SurfaceOzoneCanvasWayland::ShmBuffer*
+SurfaceOzoneCanvasWayland::GetIdleBuffer() const {
+  WaylandShmArena* arena = WaylandDisplay::GetInstance()->GetShmArena();
+  for (const auto& buffer : buffers_) {
+    if (!arena->IsBusy(buffer->shm))
+      return buffer.get();
+  }
+
+  return NULL;
+}
+
+}  // namespace ozonewayland
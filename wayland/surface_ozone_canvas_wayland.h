@@ -0,0 +1,78 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_SURFACE_OZONE_CANVAS_WAYLAND_H_
+#define OZONE_WAYLAND_SURFACE_OZONE_CANVAS_WAYLAND_H_
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "third_party/skia/include/core/SkRegion.h"
+#include "third_party/skia/include/core/SkSurface.h"
+#include "ui/gfx/geometry/size.h"
+#include "ui/ozone/public/surface_ozone_canvas.h"
+
+namespace ozonewayland {
+
+class WaylandShmBuffer;
+
+// Software rendering into wl_shm buffers from the shm arena. Runs in the GPU
+// process, where the browser sends the frames it composites in software (see
+// SurfaceOzoneCanvasHost), or wherever the Wayland connection is. Up to three
+// buffers are kept per window and reused once the compositor releases them.
+// As Chromium only repaints the damaged part of each frame, the areas
+// presented since a buffer was last drawn into are copied over from the
+// previous frame before handing it out again.
+class SurfaceOzoneCanvasWayland : public ui::SurfaceOzoneCanvas {
+ public:
+  // With |owns_window| the window is destroyed along with the canvas, as it
+  // is with its EGL surface. The canvases presenting the frames of the
+  // browser leave it to the browser.
+  SurfaceOzoneCanvasWayland(unsigned handle, bool owns_window);
+  ~SurfaceOzoneCanvasWayland() override;
+
+  // ui::SurfaceOzoneCanvas:
+  sk_sp<SkSurface> GetSurface() override;
+  void ResizeCanvas(const gfx::Size& viewport_size) override;
+  void PresentCanvas(const gfx::Rect& damage) override;
+  std::unique_ptr<gfx::VSyncProvider> CreateVSyncProvider() override;
+
+ private:
+  struct ShmBuffer {
+    ShmBuffer();
+    ~ShmBuffer();
+
+    WaylandShmBuffer* shm;
+    sk_sp<SkSurface> surface;
+    // Area presented in other buffers since this one was last drawn into.
+    SkRegion stale;
+  };
+
+  ShmBuffer* CreateBuffer();
+  void DestroyBuffers();
+  // Returns a buffer the compositor doesn't hold, waiting for one to be
+  // released when all of them are busy. Gives up waiting after a timeout
+  // and returns a busy buffer.
+  ShmBuffer* GetFreeBuffer();
+  // Brings |buffer| up to date with the last presented frame.
+  void CopyStaleRegion(ShmBuffer* buffer);
+  // Returns a buffer the compositor doesn't hold, if any.
+  ShmBuffer* GetIdleBuffer() const;
+
+  unsigned handle_;
+  bool owns_window_;
+  gfx::Size size_;
+  int stride_;
+  std::vector<std::unique_ptr<ShmBuffer>> buffers_;
+  // The buffer handed out by GetSurface, NULL until then.
+  ShmBuffer* back_buffer_;
+  // The buffer presented last, NULL before the first frame.
+  ShmBuffer* front_buffer_;
+  DISALLOW_COPY_AND_ASSIGN(SurfaceOzoneCanvasWayland);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_SURFACE_OZONE_CANVAS_WAYLAND_H_
@@ -0,0 +1,463 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/test/fake_compositor.h"
+
+#include <stdlib.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <wayland-server.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "base/stl_util.h"
+
+namespace ozonewayland {
+
+namespace {
+
+void DestroyResource(wl_client* client, wl_resource* resource) {
+  wl_resource_destroy(resource);
+}
+
+void IgnoreRect(wl_client* client,
+                wl_resource* resource,
+                int32_t x,
+                int32_t y,
+                int32_t width,
+                int32_t height) {
+}
+
+void IgnoreRegion(wl_client* client,
+                  wl_resource* resource,
+                  wl_resource* region) {
+}
+
+void IgnoreInt(wl_client* client, wl_resource* resource, int32_t value) {
+}
+
+void IgnoreUint(wl_client* client, wl_resource* resource, uint32_t value) {
+}
+
+void IgnorePosition(wl_client* client,
+                    wl_resource* resource,
+                    int32_t x,
+                    int32_t y) {
+}
+
+void IgnoreRequest(wl_client* client, wl_resource* resource) {
+}
+
+void IgnoreString(wl_client* client,
+                  wl_resource* resource,
+                  const char* value) {
+}
+
+void IgnoreMove(wl_client* client,
+                wl_resource* resource,
+                wl_resource* seat,
+                uint32_t serial) {
+}
+
+void IgnoreResize(wl_client* client,
+                  wl_resource* resource,
+                  wl_resource* seat,
+                  uint32_t serial,
+                  uint32_t edges) {
+}
+
+void IgnoreTransient(wl_client* client,
+                     wl_resource* resource,
+                     wl_resource* parent,
+                     int32_t x,
+                     int32_t y,
+                     uint32_t flags) {
+}
+
+void IgnoreFullscreen(wl_client* client,
+                      wl_resource* resource,
+                      uint32_t method,
+                      uint32_t framerate,
+                      wl_resource* output) {
+}
+
+void IgnorePopup(wl_client* client,
+                 wl_resource* resource,
+                 wl_resource* seat,
+                 uint32_t serial,
+                 wl_resource* parent,
+                 int32_t x,
+                 int32_t y,
+                 uint32_t flags) {
+}
+
+void IgnoreMaximized(wl_client* client,
+                     wl_resource* resource,
+                     wl_resource* output) {
+}
+
+const struct wl_region_interface region_implementation = {
+  DestroyResource,
+  IgnoreRect,
+  IgnoreRect
+};
+
+const struct wl_shell_surface_interface shell_surface_implementation = {
+  IgnoreUint,
+  IgnoreMove,
+  IgnoreResize,
+  IgnoreRequest,
+  IgnoreTransient,
+  IgnoreFullscreen,
+  IgnorePopup,
+  IgnoreMaximized,
+  IgnoreString,
+  IgnoreString
+};
+
+}  // namespace
+
+struct FakeCompositor::Surface {
+  FakeCompositor* compositor;
+  uint32_t id;
+  // Buffer attached since the last commit, if |attached|.
+  uint32_t pending_buffer;
+  bool attached;
+  uint32_t buffer;
+  Surface* parent;
+  wl_resource* subsurface;
+  // Subsurfaces and the surface itself, from bottom to top. Empty if the
+  // surface has no subsurfaces.
+  std::vector<Surface*> stack;
+};
+
+FakeCompositor::FakeCompositor()
+    : display_(NULL),
+      quit_fd_(-1) {
+}
+
+FakeCompositor::~FakeCompositor() {
+  if (thread_) {
+    uint64_t quit = 1;
+    HANDLE_EINTR(write(quit_fd_, &quit, sizeof(quit)));
+    thread_->Join();
+  }
+
+  if (display_)
+    wl_display_destroy(display_);
+
+  if (quit_fd_ >= 0)
+    close(quit_fd_);
+
+  STLDeleteValues(&surfaces_);
+}
+
+bool FakeCompositor::Start() {
+  // wl_display_add_socket_auto creates the socket there.
+  if (!getenv("XDG_RUNTIME_DIR")) {
+    if (!runtime_dir_.CreateUniqueTempDir())
+      return false;
+    setenv("XDG_RUNTIME_DIR", runtime_dir_.path().value().c_str(), 1);
+  }
+
+  display_ = wl_display_create();
+  const char* socket = display_ ? wl_display_add_socket_auto(display_) : NULL;
+  if (!socket)
+    return false;
+
+  setenv("WAYLAND_DISPLAY", socket, 1);
+  wl_display_init_shm(display_);
+  wl_global_create(display_, &wl_compositor_interface, 4, this,
+                   FakeCompositor::BindCompositor);
+  wl_global_create(display_, &wl_subcompositor_interface, 1, this,
+                   FakeCompositor::BindSubcompositor);
+  wl_global_create(display_, &wl_shell_interface, 1, this,
+                   FakeCompositor::BindShell);
+
+  quit_fd_ = eventfd(0, EFD_CLOEXEC);
+  if (quit_fd_ < 0)
+    return false;
+
+  wl_event_loop_add_fd(wl_display_get_event_loop(display_), quit_fd_,
+                       WL_EVENT_READABLE, FakeCompositor::OnQuit, display_);
+  thread_.reset(new base::DelegateSimpleThread(this, "FakeCompositor"));
+  thread_->Start();
+  return true;
+}
+
+std::vector<uint32_t> FakeCompositor::GetStack(uint32_t parent_id) {
+  base::AutoLock lock(lock_);
+  std::vector<uint32_t> stack;
+  std::map<uint32_t, Surface*>::const_iterator it = surfaces_.find(parent_id);
+  if (it == surfaces_.end())
+    return stack;
+
+  for (Surface* surface : it->second->stack)
+    stack.push_back(surface->id);
+
+  return stack;
+}
+
+uint32_t FakeCompositor::GetBuffer(uint32_t surface_id) {
+  base::AutoLock lock(lock_);
+  std::map<uint32_t, Surface*>::const_iterator it = surfaces_.find(surface_id);
+  return it == surfaces_.end() ? 0 : it->second->buffer;
+}
+
+void FakeCompositor::Run() {
+  wl_display_run(display_);
+}
+
+// static
+void FakeCompositor::BindCompositor(wl_client* client,
+                                    void* data,
+                                    uint32_t version,
+                                    uint32_t id) {
+  static const struct wl_compositor_interface compositor_implementation = {
+    FakeCompositor::CreateSurface,
+    FakeCompositor::CreateRegion
+  };
+
+  wl_resource* resource =
+      wl_resource_create(client, &wl_compositor_interface, version, id);
+  wl_resource_set_implementation(resource, &compositor_implementation, data,
+                                 NULL);
+}
+
+// static
+void FakeCompositor::BindSubcompositor(wl_client* client,
+                                       void* data,
+                                       uint32_t version,
+                                       uint32_t id) {
+  static const struct wl_subcompositor_interface
+      subcompositor_implementation = {
+    DestroyResource,
+    FakeCompositor::GetSubsurface
+  };
+
+  wl_resource* resource =
+      wl_resource_create(client, &wl_subcompositor_interface, version, id);
+  wl_resource_set_implementation(resource, &subcompositor_implementation,
+                                 data, NULL);
+}
+
+// static
+void FakeCompositor::BindShell(wl_client* client,
+                               void* data,
+                               uint32_t version,
+                               uint32_t id) {
+  static const struct wl_shell_interface shell_implementation = {
+    FakeCompositor::GetShellSurface
+  };
+
+  wl_resource* resource =
+      wl_resource_create(client, &wl_shell_interface, version, id);
+  wl_resource_set_implementation(resource, &shell_implementation, data, NULL);
+}
+
+// static
+int FakeCompositor::OnQuit(int fd, uint32_t mask, void* data) {
+  wl_display_terminate(static_cast<wl_display*>(data));
+  return 0;
+}
+
+// static
+void FakeCompositor::CreateSurface(wl_client* client,
+                                   wl_resource* resource,
+                                   uint32_t id) {
+  static const struct wl_surface_interface surface_implementation = {
+    DestroyResource,
+    FakeCompositor::Attach,
+    IgnoreRect,
+    FakeCompositor::Frame,
+    IgnoreRegion,
+    IgnoreRegion,
+    FakeCompositor::Commit,
+    IgnoreInt,
+    IgnoreInt,
+    IgnoreRect
+  };
+
+  FakeCompositor* compositor =
+      static_cast<FakeCompositor*>(wl_resource_get_user_data(resource));
+  Surface* surface = new Surface;
+  surface->compositor = compositor;
+  surface->id = id;
+  surface->pending_buffer = 0;
+  surface->attached = false;
+  surface->buffer = 0;
+  surface->parent = NULL;
+  surface->subsurface = NULL;
+
+  wl_resource* surface_resource = wl_resource_create(
+      client, &wl_surface_interface, wl_resource_get_version(resource), id);
+  wl_resource_set_implementation(surface_resource, &surface_implementation,
+                                 surface, FakeCompositor::DestroySurface);
+
+  base::AutoLock lock(compositor->lock_);
+  compositor->surfaces_[id] = surface;
+}
+
+// static
+void FakeCompositor::CreateRegion(wl_client* client,
+                                  wl_resource* resource,
+                                  uint32_t id) {
+  wl_resource* region = wl_resource_create(
+      client, &wl_region_interface, wl_resource_get_version(resource), id);
+  wl_resource_set_implementation(region, &region_implementation, NULL, NULL);
+}
+
+// static
+void FakeCompositor::DestroySurface(wl_resource* resource) {
+  Surface* surface = static_cast<Surface*>(wl_resource_get_user_data(resource));
+  FakeCompositor* compositor = surface->compositor;
+  if (surface->subsurface)
+    wl_resource_set_user_data(surface->subsurface, NULL);
+
+  base::AutoLock lock(compositor->lock_);
+  if (surface->parent) {
+    std::vector<Surface*>& siblings = surface->parent->stack;
+    siblings.erase(std::find(siblings.begin(), siblings.end(), surface));
+  }
+
+  for (Surface* child : surface->stack) {
+    if (child != surface)
+      child->parent = NULL;
+  }
+
+  compositor->surfaces_.erase(surface->id);
+  delete surface;
+}
+
+// static
+void FakeCompositor::Attach(wl_client* client,
+                            wl_resource* resource,
+                            wl_resource* buffer,
+                            int32_t x,
+                            int32_t y) {
+  Surface* surface = static_cast<Surface*>(wl_resource_get_user_data(resource));
+  base::AutoLock lock(surface->compositor->lock_);
+  surface->pending_buffer = buffer ? wl_resource_get_id(buffer) : 0;
+  surface->attached = true;
+}
+
+// static
+void FakeCompositor::Frame(wl_client* client,
+                           wl_resource* resource,
+                           uint32_t id) {
+  // Nothing is repainted, the callbacks never fire.
+  wl_resource_create(client, &wl_callback_interface, 1, id);
+}
+
+// static
+void FakeCompositor::Commit(wl_client* client, wl_resource* resource) {
+  Surface* surface = static_cast<Surface*>(wl_resource_get_user_data(resource));
+  base::AutoLock lock(surface->compositor->lock_);
+  if (surface->attached)
+    surface->buffer = surface->pending_buffer;
+  surface->attached = false;
+}
+
+// static
+void FakeCompositor::GetSubsurface(wl_client* client,
+                                   wl_resource* resource,
+                                   uint32_t id,
+                                   wl_resource* surface_resource,
+                                   wl_resource* parent_resource) {
+  static const struct wl_subsurface_interface subsurface_implementation = {
+    DestroyResource,
+    IgnorePosition,
+    FakeCompositor::PlaceAbove,
+    FakeCompositor::PlaceBelow,
+    IgnoreRequest,
+    IgnoreRequest
+  };
+
+  Surface* surface =
+      static_cast<Surface*>(wl_resource_get_user_data(surface_resource));
+  Surface* parent =
+      static_cast<Surface*>(wl_resource_get_user_data(parent_resource));
+  wl_resource* subsurface =
+      wl_resource_create(client, &wl_subsurface_interface, 1, id);
+  wl_resource_set_implementation(subsurface, &subsurface_implementation,
+                                 surface, FakeCompositor::DestroySubsurface);
+
+  // New subsurfaces go on top of the stack.
+  base::AutoLock lock(surface->compositor->lock_);
+  surface->subsurface = subsurface;
+  surface->parent = parent;
+  if (parent->stack.empty())
+    parent->stack.push_back(parent);
+  parent->stack.push_back(surface);
+}
+
+// static
+void FakeCompositor::DestroySubsurface(wl_resource* resource) {
+  Surface* surface = static_cast<Surface*>(wl_resource_get_user_data(resource));
+  // The surface may be gone already.
+  if (!surface)
+    return;
+
+  base::AutoLock lock(surface->compositor->lock_);
+  surface->subsurface = NULL;
+  if (!surface->parent)
+    return;
+
+  std::vector<Surface*>& siblings = surface->parent->stack;
+  siblings.erase(std::find(siblings.begin(), siblings.end(), surface));
+  surface->parent = NULL;
+}
+
+// static
+void FakeCompositor::PlaceAbove(wl_client* client,
+                                wl_resource* resource,
+                                wl_resource* sibling) {
+  Surface* surface = static_cast<Surface*>(wl_resource_get_user_data(resource));
+  surface->compositor->Restack(
+      surface,
+      static_cast<Surface*>(wl_resource_get_user_data(sibling)),
+      true);
+}
+
+// static
+void FakeCompositor::PlaceBelow(wl_client* client,
+                                wl_resource* resource,
+                                wl_resource* sibling) {
+  Surface* surface = static_cast<Surface*>(wl_resource_get_user_data(resource));
+  surface->compositor->Restack(
+      surface,
+      static_cast<Surface*>(wl_resource_get_user_data(sibling)),
+      false);
+}
+
+// static
+void FakeCompositor::GetShellSurface(wl_client* client,
+                                     wl_resource* resource,
+                                     uint32_t id,
+                                     wl_resource* surface) {
+  wl_resource* shell_surface =
+      wl_resource_create(client, &wl_shell_surface_interface, 1, id);
+  wl_resource_set_implementation(shell_surface, &shell_surface_implementation,
+                                 NULL, NULL);
+}
+
+void FakeCompositor::Restack(Surface* surface, Surface* sibling, bool above) {
+  base::AutoLock lock(lock_);
+  Surface* parent = surface->parent;
+  if (!parent || (sibling != parent && sibling->parent != parent)) {
+    LOG(ERROR) << "Subsurface " << surface->id << " restacked next to "
+               << sibling->id << ", which isn't a sibling";
+    return;
+  }
+
+  std::vector<Surface*>& stack = parent->stack;
+  stack.erase(std::find(stack.begin(), stack.end(), surface));
+  std::vector<Surface*>::iterator it =
+      std::find(stack.begin(), stack.end(), sibling);
+  stack.insert(above ? it + 1 : it, surface);
+}
+
+}  // namespace ozonewayland
@@ -0,0 +1,116 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef OZONE_WAYLAND_TEST_FAKE_COMPOSITOR_H_
+#define OZONE_WAYLAND_TEST_FAKE_COMPOSITOR_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/macros.h"
+#include "base/synchronization/lock.h"
+#include "base/threading/simple_thread.h"
+
+struct wl_client;
+struct wl_display;
+struct wl_resource;
+
+namespace ozonewayland {
+
+// An in-process Wayland server for the tests, offering wl_compositor,
+// wl_subcompositor, wl_shell and wl_shm. It doesn't render anything, it
+// records the state of the surfaces so that the tests can check what the
+// client asked for. Objects are identified by their protocol id, which is
+// the same on both sides (wl_proxy_get_id on the client).
+// Subsurface stacking and buffers are recorded as they are requested: the
+// state caching of synchronized subsurfaces isn't modelled.
+class FakeCompositor : public base::DelegateSimpleThread::Delegate {
+ public:
+  FakeCompositor();
+  ~FakeCompositor() override;
+
+  // Starts serving on a new socket and points WAYLAND_DISPLAY at it.
+  bool Start();
+
+  // Returns the surfaces in the stack of |parent_id| from bottom to top,
+  // |parent_id| included, or an empty list if it has no subsurfaces.
+  std::vector<uint32_t> GetStack(uint32_t parent_id);
+  // Returns the buffer attached with the last commit of |surface_id|, 0 if
+  // none.
+  uint32_t GetBuffer(uint32_t surface_id);
+
+  // base::DelegateSimpleThread::Delegate:
+  void Run() override;
+
+ private:
+  struct Surface;
+
+  static void BindCompositor(wl_client* client,
+                             void* data,
+                             uint32_t version,
+                             uint32_t id);
+  static void BindSubcompositor(wl_client* client,
+                                void* data,
+                                uint32_t version,
+                                uint32_t id);
+  static void BindShell(wl_client* client,
+                        void* data,
+                        uint32_t version,
+                        uint32_t id);
+  static int OnQuit(int fd, uint32_t mask, void* data);
+
+  // Request handlers, called on the server thread.
+  static void CreateSurface(wl_client* client,
+                            wl_resource* resource,
+                            uint32_t id);
+  static void CreateRegion(wl_client* client,
+                           wl_resource* resource,
+                           uint32_t id);
+  static void DestroySurface(wl_resource* resource);
+  static void Attach(wl_client* client,
+                     wl_resource* resource,
+                     wl_resource* buffer,
+                     int32_t x,
+                     int32_t y);
+  static void Frame(wl_client* client, wl_resource* resource, uint32_t id);
+  static void Commit(wl_client* client, wl_resource* resource);
+  static void GetSubsurface(wl_client* client,
+                            wl_resource* resource,
+                            uint32_t id,
+                            wl_resource* surface,
+                            wl_resource* parent);
+  static void DestroySubsurface(wl_resource* resource);
+  static void PlaceAbove(wl_client* client,
+                         wl_resource* resource,
+                         wl_resource* sibling);
+  static void PlaceBelow(wl_client* client,
+                         wl_resource* resource,
+                         wl_resource* sibling);
+  static void GetShellSurface(wl_client* client,
+                              wl_resource* resource,
+                              uint32_t id,
+                              wl_resource* surface);
+
+  // Moves |surface| next to |sibling| in the stack of their parent.
+  void Restack(Surface* surface, Surface* sibling, bool above);
+
+  wl_display* display_;
+  base::ScopedTempDir runtime_dir_;
+  int quit_fd_;
+  std::unique_ptr<base::DelegateSimpleThread> thread_;
+
+  // Guards the surfaces, written on the server thread and read by the tests.
+  base::Lock lock_;
+  std::map<uint32_t, Surface*> surfaces_;
+
+  DISALLOW_COPY_AND_ASSIGN(FakeCompositor);
+};
+
+}  // namespace ozonewayland
+
+#endif  // OZONE_WAYLAND_TEST_FAKE_COMPOSITOR_H_
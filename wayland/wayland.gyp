@@ -46,7 +46,7 @@
         ],
         'libraries': [
           '<!@(<(pkg-config) --libs-only-l <(wayland_packages))',
-          '-lilmInput -lilmCommon',
+          '-lilmInput -lilmControl -lilmCommon',
         ],
       },
       'dependencies': [
@@ -68,20 +68,37 @@
         'display.h',
         'display_poll_thread.cc',
         'display_poll_thread.h',
+        'lock_free_queue.h',
         'ozone_wayland_screen.cc',
         'ozone_wayland_screen.h',
+        'render_scale_policy.cc',
+        'render_scale_policy.h',
         'screen.cc',
         'screen.h',
         'seat.cc',
         'seat.h',
+        'shm_arena.cc',
+        'shm_arena.h',
+        'subsurface.cc',
+        'subsurface.h',
+        'surface_ozone_canvas_wayland.cc',
+        'surface_ozone_canvas_wayland.h',
         'window.cc',
         'window.h',
         'egl/egl_window.cc',
         'egl/egl_window.h',
         'egl/surface_ozone_wayland.cc',
         'egl/surface_ozone_wayland.h',
+        'egl/vsync_provider_wayland.cc',
+        'egl/vsync_provider_wayland.h',
         'input/cursor.cc',
         'input/cursor.h',
+        'input/cursor_cache.cc',
+        'input/cursor_cache.h',
+        'input/cursor_theme.cc',
+        'input/cursor_theme.h',
+        'input/event_coalescer.cc',
+        'input/event_coalescer.h',
         'input/keyboard.cc',
         'input/keyboard.h',
         'input/pointer.cc',
@@ -94,6 +111,10 @@
         'protocol/text-client-protocol.h',
         'protocol/ivi-application-protocol.c',
         'protocol/ivi-application-client-protocol.h',
+        'protocol/presentation-time-protocol.c',
+        'protocol/presentation-time-client-protocol.h',
+        'protocol/viewporter-protocol.c',
+        'protocol/viewporter-client-protocol.h',
         'protocol/xdg-shell-protocol.c',
         'protocol/xdg-shell-client-protocol.h',
         'shell/shell.cc',
@@ -108,5 +129,33 @@
         'shell/ivi_shell_surface.h',
       ],
     },
+    {
+      # Runs against an in-process compositor, without a GPU.
+      'target_name': 'ozone_wayland_unittests',
+      'type': 'executable',
+      'cflags': [
+        '<!@(<(pkg-config) --cflags wayland-server)',
+      ],
+      'link_settings': {
+        'libraries': [
+          '<!@(<(pkg-config) --libs-only-l wayland-server)',
+        ],
+      },
+      'dependencies': [
+        '../../base/base.gyp:run_all_unittests',
+        '../../testing/gtest.gyp:gtest',
+        '../ozone_impl.gyp:wayland',
+        'wayland_toolkit',
+      ],
+      'include_dirs': [
+        '../..',
+      ],
+      'sources': [
+        '../platform/overlay_manager_wayland_unittest.cc',
+        'test/fake_compositor.cc',
+        'test/fake_compositor.h',
+        'window_unittest.cc',
+      ],
+    },
   ]
 }
@@ -5,20 +5,96 @@
 
 #include "ozone/wayland/window.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
 #include "base/logging.h"
+#include "base/trace_event/trace_event.h"
 #include "ozone/wayland/display.h"
 #include "ozone/wayland/egl/egl_window.h"
+#include "ozone/wayland/protocol/presentation-time-client-protocol.h"
+#include "ozone/wayland/protocol/viewporter-client-protocol.h"
+#include "ozone/wayland/render_scale_policy.h"
+#include "ozone/wayland/screen.h"
 #include "ozone/wayland/seat.h"
 #include "ozone/wayland/shell/shell.h"
 #include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/subsurface.h"
+#include "ui/gfx/geometry/size_conversions.h"
 
 namespace ozonewayland {
 
+namespace {
+
+// Used when the output doesn't report its refresh rate.
+const int32_t kDefaultRefreshRate = 60000;
+
+// Lets the compositor hold one frame while the next one is being rendered.
+const size_t kDefaultMaxFramesInFlight = 2;
+
+// Longest ThrottleFrames() waits for the compositor, and longest a frame
+// waits for it before its completion runs anyway. Hidden, minimized or
+// occluded surfaces don't get frame callbacks.
+const int kFrameTimeoutMs = 100;
+
+// Frames committed after a configure before it is acknowledged even though
+// the window wasn't resized to it, e.g. because of its size constraints.
+const int kMaxFramesBeforeConfigureAck = 3;
+
+// EGL buffers are RGBA8888.
+const int kBytesPerPixel = 4;
+
+}  // namespace
+
+struct WaylandWindow::PendingFrame {
+  WaylandWindow* window;
+  wl_callback* callback;
+  base::Closure frame_done;
+  base::TimeTicks commit_time;
+};
+
+struct WaylandWindow::PendingPresentation {
+  WaylandWindow* window;
+  wp_presentation_feedback* feedback;
+  base::TimeTicks commit_time;
+};
+
 WaylandWindow::WaylandWindow(unsigned handle) : shell_surface_(NULL),
     window_(NULL),
+    queue_(NULL),
+    next_frame_(NULL),
+    next_presentation_(NULL),
+    max_frames_in_flight_(kDefaultMaxFramesInFlight),
+    frames_overdue_(false),
+    last_presentation_flags_(0),
+    viewport_(NULL),
+    resize_quantum_(0),
+    buffer_reallocations_(0),
+    render_scale_(1.f),
+    requested_render_scale_(1.f),
+    frames_since_configure_(0),
+    region_(NULL),
     type_(None),
     handle_(handle),
     allocation_(gfx::Rect(0, 0, 1, 1)) {
+  queue_ = wl_display_create_queue(WaylandDisplay::GetInstance()->display());
+
+  char *env;
+  if ((env = getenv("OZONE_WAYLAND_MAX_FRAMES_IN_FLIGHT")) && atoi(env) > 0)
+    SetMaxFramesInFlight(atoi(env));
+
+  if ((env = getenv("OZONE_WAYLAND_RESIZE_QUANTUM")))
+    resize_quantum_ = std::max(atoi(env), 0);
+
+  // Lowest render scale the window may go down to when it can't keep up with
+  // the refresh rate, e.g. 0.5. Disabled unless set.
+  if ((env = getenv("OZONE_WAYLAND_MIN_RENDER_SCALE")) && atof(env) > 0) {
+    render_scale_policy_.reset(
+        new DeadlineRenderScalePolicy(static_cast<float>(atof(env))));
+  }
 }
 
 WaylandWindow::~WaylandWindow() {
@@ -31,8 +107,42 @@ WaylandWindow::~WaylandWindow() {
       seat->SetGrabWindowHandle(0, 0);
   }
 
+  // The GPU side is tearing down the surface, nobody waits for these anymore.
+  if (next_frame_) {
+    wl_callback_destroy(next_frame_->callback);
+    delete next_frame_;
+  }
+
+  if (next_presentation_) {
+    wp_presentation_feedback_destroy(next_presentation_->feedback);
+    delete next_presentation_;
+  }
+
+  WaylandDisplay::GetInstance()->FramesDone(pending_frames_.size());
+  for (PendingFrame* frame : pending_frames_) {
+    wl_callback_destroy(frame->callback);
+    delete frame;
+  }
+
+  for (PendingPresentation* presentation : pending_presentations_) {
+    TRACE_EVENT_ASYNC_END0("ozone", "WaylandWindow::Presentation",
+                           presentation);
+    wp_presentation_feedback_destroy(presentation->feedback);
+    delete presentation;
+  }
+
+  if (region_)
+    wl_region_destroy(region_);
+
+  if (viewport_)
+    wp_viewport_destroy(viewport_);
+
+  for (const auto& overlay : overlays_)
+    delete overlay.second;
+
   delete window_;
   delete shell_surface_;
+  wl_event_queue_destroy(queue_);
 }
 
 void WaylandWindow::SetShellAttributes(ShellType type) {
@@ -43,6 +153,7 @@ void WaylandWindow::SetShellAttributes(ShellType type) {
     shell_surface_ =
         WaylandDisplay::GetInstance()->GetShell()->CreateShellSurface(this,
                                                                       type);
+    AddSurfaceListener();
   }
 
   type_ = type;
@@ -60,6 +171,7 @@ void WaylandWindow::SetShellAttributes(ShellType type,
     shell_surface_ =
         WaylandDisplay::GetInstance()->GetShell()->CreateShellSurface(this,
                                                                       type);
+    AddSurfaceListener();
   }
 
   type_ = type;
@@ -109,10 +221,467 @@ void WaylandWindow::RealizeAcceleratedWidget() {
     SetShellAttributes(TOPLEVEL);
   }
 
-  if (!window_)
+  if (!window_) {
+    render_size_ = allocation_.size();
+    buffer_size_ = GetBufferSize(render_size_);
     window_ = new EGLWindow(shell_surface_->GetWLSurface(),
-                            allocation_.width(),
-                            allocation_.height());
+                            buffer_size_.width(),
+                            buffer_size_.height());
+    UpdateViewport();
+    PrepareFrame();
+  }
+}
+
+void WaylandWindow::PrepareFrame() {
+  if (!shell_surface_ || next_frame_)
+    return;
+
+  static const struct wl_callback_listener frame_listener = {
+    WaylandWindow::OnFrameDone
+  };
+
+  wl_surface* surface = shell_surface_->GetWLSurface();
+  next_frame_ = new PendingFrame;
+  next_frame_->window = this;
+  next_frame_->callback = wl_surface_frame(surface);
+  wl_callback_add_listener(next_frame_->callback, &frame_listener, next_frame_);
+  next_presentation_ = RequestPresentationFeedback(surface);
+}
+
+void WaylandWindow::DidCommitFrame(const base::Closure& frame_done) {
+  if (!next_frame_) {
+    if (!frame_done.is_null())
+      frame_done.Run();
+    PrepareFrame();
+    return;
+  }
+
+  if (render_scale_policy_ && !last_frame_time_.is_null() &&
+      WaylandDisplay::GetInstance()->GetViewporter()) {
+    float scale = render_scale_policy_->DidSwapFrame(
+        base::TimeTicks::Now() - last_frame_time_,
+        GetRefreshInterval(),
+        requested_render_scale_);
+    if (scale != requested_render_scale_) {
+      requested_render_scale_ = scale;
+      TRACE_COUNTER_ID1("ozone", "WaylandWindow::RenderScale", handle_,
+                        scale * 100);
+      WaylandDisplay::GetInstance()->RenderScaleRequested(handle_, scale);
+    }
+  }
+
+  next_frame_->frame_done = frame_done;
+  next_frame_->commit_time = base::TimeTicks::Now();
+  pending_frames_.push_back(next_frame_);
+  next_frame_ = NULL;
+  WaylandDisplay::GetInstance()->FrameCommitted();
+  if (!frame_done.is_null() && !frame_timeout_.IsRunning()) {
+    frame_timeout_.Start(FROM_HERE,
+                         base::TimeDelta::FromMilliseconds(kFrameTimeoutMs),
+                         base::Bind(&WaylandWindow::OnFrameTimeout,
+                                    base::Unretained(this)));
+  }
+  if (next_presentation_) {
+    next_presentation_->commit_time = base::TimeTicks::Now();
+    pending_presentations_.push_back(next_presentation_);
+    TRACE_EVENT_ASYNC_BEGIN0("ozone", "WaylandWindow::Presentation",
+                             next_presentation_);
+    next_presentation_ = NULL;
+  }
+
+  // Don't keep the shell waiting for a size the window doesn't take.
+  if (!configure_size_.IsEmpty() &&
+      ++frames_since_configure_ >= kMaxFramesBeforeConfigureAck) {
+    AckConfigure();
+  }
+
+  PrepareFrame();
+  WaylandDisplay::GetInstance()->ScheduleFlush();
+}
+
+void WaylandWindow::ThrottleFrames() {
+  if (frames_overdue_ || pending_frames_.size() <= max_frames_in_flight_)
+    return;
+
+  TRACE_EVENT1("ozone", "WaylandWindow::ThrottleFrames",
+               "frames_in_flight", pending_frames_.size());
+  WaylandDisplay::GetInstance()->FlushDisplay();
+  base::TimeTicks deadline = base::TimeTicks::Now() +
+      base::TimeDelta::FromMilliseconds(kFrameTimeoutMs);
+  while (pending_frames_.size() > max_frames_in_flight_) {
+    if (!WaitForEvents(deadline)) {
+      // Don't throttle again before the compositor repaints the window.
+      frames_overdue_ = true;
+      return;
+    }
+  }
+}
+
+void WaylandWindow::OnFrameTimeout() {
+  // The frames stay pending until their frame callback, or until the window
+  // is destroyed, only their completions run.
+  base::TimeTicks now = base::TimeTicks::Now();
+  base::TimeDelta timeout = base::TimeDelta::FromMilliseconds(kFrameTimeoutMs);
+  std::vector<base::Closure> expired;
+  for (PendingFrame* frame : pending_frames_) {
+    if (frame->frame_done.is_null())
+      continue;
+
+    base::TimeDelta age = now - frame->commit_time;
+    if (age < timeout) {
+      frame_timeout_.Start(FROM_HERE, timeout - age,
+                           base::Bind(&WaylandWindow::OnFrameTimeout,
+                                      base::Unretained(this)));
+      break;
+    }
+
+    expired.push_back(frame->frame_done);
+    frame->frame_done.Reset();
+  }
+
+  if (expired.empty())
+    return;
+
+  TRACE_EVENT1("ozone", "WaylandWindow::OnFrameTimeout",
+               "frames", expired.size());
+  frames_overdue_ = true;
+  for (const base::Closure& frame_done : expired)
+    frame_done.Run();
+}
+
+bool WaylandWindow::WaitForEvents(base::TimeTicks deadline) {
+  // The input thread reads the events of all the queues, see
+  // WaylandDisplay::StartProcessingEvents. Events it read before the count is
+  // taken are dispatched here, later ones end the wait.
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  uint32_t events_read = display->events_read_count();
+  if (wl_display_dispatch_queue_pending(display->display(), queue_) > 0) {
+    DispatchEventQueue();
+    return true;
+  }
+
+  if (!display->WaitForEventsRead(events_read, deadline))
+    return false;
+
+  DispatchEventQueue();
+  return true;
+}
+
+void WaylandWindow::SetRenderScalePolicy(
+    std::unique_ptr<WaylandRenderScalePolicy> policy) {
+  render_scale_policy_ = std::move(policy);
+}
+
+void WaylandWindow::SetRenderScale(float scale, const gfx::Size& logical_size) {
+  render_scale_ = scale;
+  logical_size_ = logical_size;
+  if (render_scale_ == 1.f)
+    return;
+
+  allocation_.set_size(logical_size_);
+  if (window_)
+    UpdateViewport();
+}
+
+void WaylandWindow::SetMaxFramesInFlight(size_t max_frames) {
+  max_frames_in_flight_ = std::max<size_t>(max_frames, 1);
+}
+
+base::TimeDelta WaylandWindow::GetRefreshInterval() const {
+  if (!presentation_refresh_.is_zero())
+    return presentation_refresh_;
+
+  WaylandScreen* screen = GetCurrentScreen();
+  int32_t refresh = screen ? screen->RefreshRate() : 0;
+  if (refresh <= 0)
+    refresh = kDefaultRefreshRate;
+
+  return base::TimeDelta::FromMicroseconds(
+      base::Time::kMicrosecondsPerSecond * 1000 / refresh);
+}
+
+WaylandWindow::PendingPresentation* WaylandWindow::RequestPresentationFeedback(
+    wl_surface* surface) {
+  wp_presentation* presentation =
+      WaylandDisplay::GetInstance()->GetPresentation();
+  if (!presentation)
+    return NULL;
+
+  static const struct wp_presentation_feedback_listener feedback_listener = {
+    WaylandWindow::OnSyncOutput,
+    WaylandWindow::OnPresented,
+    WaylandWindow::OnDiscarded
+  };
+
+  PendingPresentation* pending = new PendingPresentation;
+  pending->window = this;
+  pending->feedback = wp_presentation_feedback(presentation, surface);
+  // wp_presentation lives on the default queue, the feedback belongs with the
+  // other events of the window. Nothing can be received for it before the
+  // commit is flushed.
+  wl_proxy_set_queue(reinterpret_cast<wl_proxy*>(pending->feedback), queue_);
+  wp_presentation_feedback_add_listener(pending->feedback,
+                                        &feedback_listener,
+                                        pending);
+  return pending;
+}
+
+void WaylandWindow::RemovePresentation(PendingPresentation* presentation) {
+  pending_presentations_.erase(std::remove(pending_presentations_.begin(),
+                                           pending_presentations_.end(),
+                                           presentation),
+                               pending_presentations_.end());
+  wp_presentation_feedback_destroy(presentation->feedback);
+  delete presentation;
+}
+
+void WaylandWindow::AddSurfaceListener() {
+  static const struct wl_surface_listener surface_listener = {
+    WaylandWindow::OnSurfaceEnter,
+    WaylandWindow::OnSurfaceLeave
+  };
+
+  wl_surface_add_listener(shell_surface_->GetWLSurface(),
+                          &surface_listener,
+                          this);
+}
+
+gfx::Size WaylandWindow::GetBufferSize(const gfx::Size& size) const {
+  if (resize_quantum_ <= 1 || !WaylandDisplay::GetInstance()->GetViewporter())
+    return size;
+
+  int quantum = resize_quantum_;
+  return gfx::Size((size.width() + quantum - 1) / quantum * quantum,
+                   (size.height() + quantum - 1) / quantum * quantum);
+}
+
+void WaylandWindow::UpdateViewport() {
+  bool unscaled = buffer_size_ == render_size_ &&
+      render_size_ == allocation_.size();
+  if (!viewport_) {
+    if (unscaled)
+      return;
+
+    viewport_ = wp_viewporter_get_viewport(
+        WaylandDisplay::GetInstance()->GetViewporter(),
+        shell_surface_->GetWLSurface());
+  }
+
+  if (unscaled) {
+    // -1 unsets the crop and the scaling.
+    wp_viewport_set_source(viewport_,
+                           wl_fixed_from_int(-1),
+                           wl_fixed_from_int(-1),
+                           wl_fixed_from_int(-1),
+                           wl_fixed_from_int(-1));
+    wp_viewport_set_destination(viewport_, -1, -1);
+    return;
+  }
+
+  // GL renders the window from the bottom left corner of the buffer, at the
+  // render scale.
+  wp_viewport_set_source(
+      viewport_,
+      wl_fixed_from_int(0),
+      wl_fixed_from_int(buffer_size_.height() - render_size_.height()),
+      wl_fixed_from_int(render_size_.width()),
+      wl_fixed_from_int(render_size_.height()));
+  wp_viewport_set_destination(viewport_,
+                              allocation_.width(),
+                              allocation_.height());
+}
+
+void WaylandWindow::ScheduleOverlay(int z_order,
+                                    wl_buffer* buffer,
+                                    const gfx::Point& position) {
+  DCHECK_NE(z_order, 0);
+  if (!shell_surface_ || !WaylandDisplay::GetInstance()->GetSubcompositor())
+    return;
+
+  WaylandSubsurface* overlay;
+  std::map<int, WaylandSubsurface*>::iterator it = overlays_.find(z_order);
+  if (it == overlays_.end()) {
+    overlay = new WaylandSubsurface(shell_surface_->GetWLSurface());
+    overlays_[z_order] = overlay;
+    RestackOverlays();
+  } else {
+    overlay = it->second;
+  }
+
+  overlay->Attach(buffer, position);
+}
+
+void WaylandWindow::CommitOverlays() {
+  for (const auto& overlay : overlays_) {
+    if (overlay.second->visible())
+      overlay.second->Hide();
+  }
+}
+
+void WaylandWindow::RestackOverlays() {
+  wl_surface* surface = shell_surface_->GetWLSurface();
+  wl_surface* above = surface;
+  for (std::map<int, WaylandSubsurface*>::iterator it =
+           overlays_.upper_bound(0);
+       it != overlays_.end(); ++it) {
+    it->second->PlaceAbove(above);
+    above = it->second->GetWLSurface();
+  }
+
+  wl_surface* below = surface;
+  for (std::map<int, WaylandSubsurface*>::reverse_iterator it(
+           overlays_.lower_bound(0));
+       it != overlays_.rend(); ++it) {
+    it->second->PlaceBelow(below);
+    below = it->second->GetWLSurface();
+  }
+}
+
+WaylandScreen* WaylandWindow::GetCurrentScreen() const {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  if (outputs_.empty())
+    return display->PrimaryScreen();
+
+  for (WaylandScreen* screen : display->GetScreenList()) {
+    if (screen->GetOutput() == outputs_.back())
+      return screen;
+  }
+
+  return display->PrimaryScreen();
+}
+
+// static
+void WaylandWindow::OnFrameDone(void* data,
+                                wl_callback* callback,
+                                uint32_t time) {
+  PendingFrame* frame = static_cast<PendingFrame*>(data);
+  WaylandWindow* window = frame->window;
+  DCHECK_EQ(frame->callback, callback);
+  wl_callback_destroy(callback);
+  window->frames_overdue_ = false;
+
+  // |time| is in milliseconds, with an undefined base. Compositors use the
+  // monotonic clock in practice, as TimeTicks does, so use it when it is
+  // plausible to avoid the latency of getting here.
+  // Presentation feedback, when vsync'd, gives a more accurate timebase.
+  if (!(window->last_presentation_flags_ &
+        WP_PRESENTATION_FEEDBACK_KIND_VSYNC)) {
+    base::TimeTicks now = base::TimeTicks::Now();
+    uint32_t now_ms = (now - base::TimeTicks()).InMilliseconds();
+    uint32_t age = now_ms - time;
+    if (age < base::Time::kMillisecondsPerSecond)
+      window->last_frame_time_ = now - base::TimeDelta::FromMilliseconds(age);
+    else
+      window->last_frame_time_ = now;
+  }
+
+  // A repaint covers every frame committed before this one, run their
+  // completions too so that they stay in order.
+  std::deque<PendingFrame*>& frames = window->pending_frames_;
+  std::deque<PendingFrame*>::iterator it =
+      std::find(frames.begin(), frames.end(), frame);
+  DCHECK(it != frames.end());
+  std::deque<PendingFrame*> done(frames.begin(), it + 1);
+  frames.erase(frames.begin(), it + 1);
+  WaylandDisplay::GetInstance()->FramesDone(done.size());
+  for (PendingFrame* pending : done) {
+    if (pending != frame)
+      wl_callback_destroy(pending->callback);
+    if (!pending->frame_done.is_null())
+      pending->frame_done.Run();
+    delete pending;
+  }
+}
+
+// static
+void WaylandWindow::OnSyncOutput(void* data,
+                                 wp_presentation_feedback* feedback,
+                                 wl_output* output) {
+}
+
+// static
+void WaylandWindow::OnPresented(void* data,
+                                wp_presentation_feedback* feedback,
+                                uint32_t tv_sec_hi,
+                                uint32_t tv_sec_lo,
+                                uint32_t tv_nsec,
+                                uint32_t refresh,
+                                uint32_t seq_hi,
+                                uint32_t seq_lo,
+                                uint32_t flags) {
+  PendingPresentation* presentation = static_cast<PendingPresentation*>(data);
+  WaylandWindow* window = presentation->window;
+  uint64_t seconds = (static_cast<uint64_t>(tv_sec_hi) << 32) | tv_sec_lo;
+  base::TimeTicks presented =
+      WaylandDisplay::GetInstance()->PresentationTimeToTimeTicks(seconds,
+                                                                 tv_nsec);
+  TRACE_EVENT_ASYNC_END2("ozone", "WaylandWindow::Presentation", presentation,
+                         "latency_us",
+                         (presented - presentation->commit_time)
+                             .InMicroseconds(),
+                         "flags", flags);
+
+  window->last_presentation_flags_ = flags;
+  if (flags & WP_PRESENTATION_FEEDBACK_KIND_VSYNC)
+    window->last_frame_time_ = presented;
+  window->presentation_refresh_ = base::TimeDelta::FromMicroseconds(
+      refresh / base::Time::kNanosecondsPerMicrosecond);
+  window->RemovePresentation(presentation);
+}
+
+// static
+void WaylandWindow::OnDiscarded(void* data,
+                                wp_presentation_feedback* feedback) {
+  PendingPresentation* presentation = static_cast<PendingPresentation*>(data);
+  TRACE_EVENT_ASYNC_END1("ozone", "WaylandWindow::Presentation", presentation,
+                         "discarded", true);
+  presentation->window->RemovePresentation(presentation);
+}
+
+// static
+void WaylandWindow::OnSurfaceEnter(void* data,
+                                   wl_surface* surface,
+                                   wl_output* output) {
+  WaylandWindow* window = static_cast<WaylandWindow*>(data);
+  window->outputs_.push_back(output);
+}
+
+// static
+void WaylandWindow::OnSurfaceLeave(void* data,
+                                   wl_surface* surface,
+                                   wl_output* output) {
+  WaylandWindow* window = static_cast<WaylandWindow*>(data);
+  window->outputs_.erase(std::remove(window->outputs_.begin(),
+                                     window->outputs_.end(),
+                                     output),
+                         window->outputs_.end());
+}
+
+void WaylandWindow::DispatchEventQueue() {
+  WaylandDisplay* display = WaylandDisplay::GetInstance();
+  wl_display_dispatch_queue_pending(display->display(), queue_);
+
+  if (!pending_configure_size_.IsEmpty()) {
+    display->WindowResized(handle_,
+                           pending_configure_size_.width(),
+                           pending_configure_size_.height());
+    pending_configure_size_ = gfx::Size();
+  }
+}
+
+void WaylandWindow::OnConfigure(unsigned width, unsigned height) {
+  if (!width || !height)
+    return;
+
+  pending_configure_size_ = gfx::Size(width, height);
+  configure_size_ = pending_configure_size_;
+  frames_since_configure_ = 0;
+}
+
+void WaylandWindow::AckConfigure() {
+  configure_size_ = gfx::Size();
+  if (shell_surface_)
+    shell_surface_->AckPendingConfigure();
 }
 
 wl_egl_window* WaylandWindow::egl_window() const {
@@ -121,15 +690,54 @@ wl_egl_window* WaylandWindow::egl_window() const {
 }
 
 void WaylandWindow::Resize(unsigned width, unsigned height) {
-  if ((allocation_.width() == width) && (allocation_.height() == height))
+  gfx::Size render_size(width, height);
+  // The browser confirms the render scale with WaylandDisplay_RenderScale,
+  // which may arrive after the GL surface has been resized for it. Don't
+  // shrink the window to the reduced size meanwhile.
+  if (requested_render_scale_ != 1.f &&
+      requested_render_scale_ != render_scale_ &&
+      render_size == gfx::ScaleToCeiledSize(allocation_.size(),
+                                            requested_render_scale_)) {
+    render_scale_ = requested_render_scale_;
+    logical_size_ = allocation_.size();
+  }
+
+  // The next frame is drawn at the configured size, its commit carries the
+  // acknowledgement.
+  if (!configure_size_.IsEmpty() &&
+      configure_size_ == (render_scale_ == 1.f ? render_size : logical_size_)) {
+    AckConfigure();
+  }
+
+  if (render_size == render_size_)
     return;
 
-  allocation_ = gfx::Rect(allocation_.x(), allocation_.y(), width, height);
+  render_size_ = render_size;
+  allocation_.set_size(
+      render_scale_ == 1.f ? render_size_ : logical_size_);
   if (!shell_surface_ || !window_)
     return;
 
-  window_->Resize(allocation_.width(), allocation_.height());
-  WaylandDisplay::GetInstance()->FlushDisplay();
+  gfx::Size buffer_size = GetBufferSize(render_size_);
+  if (buffer_size != buffer_size_) {
+    buffer_size_ = buffer_size;
+    buffer_reallocations_++;
+    window_->Resize(buffer_size_.width(), buffer_size_.height());
+  }
+
+  UpdateViewport();
+  TRACE_COUNTER_ID2("ozone", "WaylandWindow::Buffers", handle_,
+                    "reallocations", buffer_reallocations_,
+                    "overhead_bytes", GetBufferMemoryOverhead());
+  WaylandDisplay::GetInstance()->ScheduleFlush();
+}
+
+int64_t WaylandWindow::GetBufferMemoryOverhead() const {
+  int64_t buffer_area =
+      static_cast<int64_t>(buffer_size_.width()) * buffer_size_.height();
+  int64_t render_area =
+      static_cast<int64_t>(render_size_.width()) * render_size_.height();
+  return std::max<int64_t>(buffer_area - render_area, 0) * kBytesPerPixel;
 }
 
 void WaylandWindow::Move(ShellType type, WaylandShellSurface* shell_parent,
@@ -147,24 +755,35 @@ void WaylandWindow::Move(ShellType type, WaylandShellSurface* shell_parent,
   int move_x = x - allocation_.x();
   int move_y = y - allocation_.y();
   allocation_ = rect;
-  window_->Move(allocation_.width(), allocation_.height(), move_x, move_y);
+  if (render_scale_ == 1.f)
+    render_size_ = rect.size();
+  else
+    allocation_.set_size(logical_size_);
+  buffer_size_ = GetBufferSize(render_size_);
+  window_->Move(buffer_size_.width(), buffer_size_.height(), move_x, move_y);
+  UpdateViewport();
 }
 
-void WaylandWindow::AddRegion(int left, int top, int right, int bottom) {
-  wl_compositor* com = WaylandDisplay::GetInstance()->GetCompositor();
-  struct wl_region *region = wl_compositor_create_region(com);
-  wl_region_add(region, left, top, right, bottom);
-  wl_surface_set_input_region(shell_surface_->GetWLSurface(), region);
-  wl_surface_set_opaque_region(shell_surface_->GetWLSurface(), region);
-  wl_region_destroy(region);
-}
+void WaylandWindow::SetRegion(const std::vector<gfx::Rect>& rects) {
+  if (rects == region_rects_)
+    return;
+
+  region_rects_ = rects;
+  if (region_) {
+    wl_region_destroy(region_);
+    region_ = NULL;
+  }
+
+  if (!rects.empty()) {
+    wl_compositor* com = WaylandDisplay::GetInstance()->GetCompositor();
+    region_ = wl_compositor_create_region(com);
+    for (const gfx::Rect& rect : rects)
+      wl_region_add(region_, rect.x(), rect.y(), rect.width(), rect.height());
+  }
 
-void WaylandWindow::SubRegion(int left, int top, int right, int bottom) {
-  wl_compositor* com = WaylandDisplay::GetInstance()->GetCompositor();
-  struct wl_region *region = wl_compositor_create_region(com);
-  wl_region_subtract(region, left, top, right, bottom);
-  wl_surface_set_opaque_region(shell_surface_->GetWLSurface(), region);
-  wl_region_destroy(region);
+  // A NULL opaque region is empty and a NULL input region is infinite.
+  wl_surface_set_input_region(shell_surface_->GetWLSurface(), region_);
+  wl_surface_set_opaque_region(shell_surface_->GetWLSurface(), region_);
 }
 
 }  // namespace ozonewayland
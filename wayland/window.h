@@ -8,12 +8,26 @@
 
 #include <wayland-client.h>
 
+#include <deque>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
 #include "base/strings/string16.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
 #include "ui/gfx/geometry/rect.h"
 
+struct wp_presentation_feedback;
+struct wp_viewport;
+
 namespace ozonewayland {
 
+class WaylandRenderScalePolicy;
+class WaylandScreen;
 class WaylandShellSurface;
+class WaylandSubsurface;
 class EGLWindow;
 struct wl_egl_window;
 
@@ -48,24 +62,180 @@ class WaylandWindow {
   unsigned Handle() const { return handle_; }
   WaylandShellSurface* ShellSurface() const { return shell_surface_; }
 
+  // Returns the queue receiving the events of the surface and shell objects
+  // of this window. The WaylandWindow object owns the queue.
+  wl_event_queue* event_queue() const { return queue_; }
+  // Dispatches the events already read into event_queue(). This must be
+  // called on the thread owning the window.
+  void DispatchEventQueue();
+
   void RealizeAcceleratedWidget();
 
   // Returns pointer to egl window associated with the window.
   // The WaylandWindow object owns the pointer.
   wl_egl_window* egl_window() const;
 
-  // Immediately Resizes window and flushes Wayland Display.
+  // Records the size requested by the shell. Only the latest size received
+  // during a dispatch cycle is forwarded to the browser, from
+  // DispatchEventQueue, so that interactive resizes don't reallocate the
+  // window for every intermediate size.
+  void OnConfigure(unsigned width, unsigned height);
+
+  // Immediately Resizes window and flushes Wayland Display. With a resize
+  // quantum set (OZONE_WAYLAND_RESIZE_QUANTUM, in pixels) and wp_viewporter
+  // available, the EGL buffers are allocated in multiples of the quantum and
+  // cropped to the window size, so they are only reallocated when the size
+  // crosses a multiple of it.
   void Resize(unsigned width, unsigned height);
+  // Number of times the EGL buffers were resized.
+  int buffer_reallocations() const { return buffer_reallocations_; }
+  // Bytes allocated per EGL buffer beyond the window size.
+  int64_t GetBufferMemoryOverhead() const;
   void Move(ShellType type,
             WaylandShellSurface* shell_parent,
             const gfx::Rect& rect);
-  void AddRegion(int left, int top, int right, int bottom);
-  void SubRegion(int left, int top, int right, int bottom);
+  // Sets the opaque and input region of the surface to the union of |rects|,
+  // or resets them if |rects| is empty. Does nothing if they are unchanged.
+  void SetRegion(const std::vector<gfx::Rect>& rects);
   gfx::Rect GetBounds() const { return allocation_; }
 
+  // Requests a wl_surface.frame callback, and presentation feedback when the
+  // compositor supports wp_presentation, for the next commit of the surface.
+  // Both apply to the commit that follows them, so they are requested ahead
+  // of the swap that makes it. Does nothing if they are already requested.
+  void PrepareFrame();
+  // Called once the surface has been committed with a new frame. The frame
+  // callback prepared for it tells when the compositor repainted the outputs
+  // showing the window, which is used as the vsync timebase, or the actual
+  // presentation time when feedback is available. |frame_done|, if not null,
+  // is run once the compositor is done with the frame, or after a timeout
+  // when the window isn't repainted, e.g. while it is hidden. Frames complete
+  // in the order they were committed. Prepares the next frame.
+  void DidCommitFrame(const base::Closure& frame_done);
+  size_t frames_in_flight() const { return pending_frames_.size(); }
+  // Blocks until no more than max_frames_in_flight() frames are waiting for
+  // the compositor, dispatching the window's event queue meanwhile. Gives up
+  // after a timeout, and doesn't block again until the compositor sends a
+  // frame callback.
+  void ThrottleFrames();
+  // Waits until the window has pending events or the input thread reads new
+  // ones, or until |deadline| passes, then dispatches them with
+  // DispatchEventQueue(). Returns false on timeout.
+  bool WaitForEvents(base::TimeTicks deadline);
+  // Maximum number of swapped frames the compositor may hold before
+  // ThrottleFrames() blocks. Defaults to OZONE_WAYLAND_MAX_FRAMES_IN_FLIGHT.
+  void SetMaxFramesInFlight(size_t max_frames);
+  size_t max_frames_in_flight() const { return max_frames_in_flight_; }
+
+  // Dynamic render resolution. The policy, if any, is consulted on every
+  // swap and the scale it picks is sent to the browser, which then renders
+  // at that fraction of the window size and calls SetRenderScale. The
+  // compositor scales the content back to |logical_size| with wp_viewporter.
+  // OZONE_WAYLAND_MIN_RENDER_SCALE enables DeadlineRenderScalePolicy.
+  void SetRenderScalePolicy(std::unique_ptr<WaylandRenderScalePolicy> policy);
+  void SetRenderScale(float scale, const gfx::Size& logical_size);
+  float render_scale() const { return render_scale_; }
+  // Time at which the compositor last repainted the window, null until the
+  // first frame callback is received.
+  base::TimeTicks last_frame_time() const { return last_frame_time_; }
+  // Returns the refresh interval reported by the last presentation feedback
+  // or else that of the output the window entered last, or of the primary
+  // output if it hasn't entered any yet.
+  base::TimeDelta GetRefreshInterval() const;
+  // wp_presentation_feedback_kind flags of the last presented frame.
+  uint32_t last_presentation_flags() const { return last_presentation_flags_; }
+
+  // Shows |buffer| at |position| in a subsurface of the window for the next
+  // frame. Overlays with a positive |z_order| are stacked above the window
+  // surface in increasing order, negative ones below it in decreasing order.
+  void ScheduleOverlay(int z_order,
+                       wl_buffer* buffer,
+                       const gfx::Point& position);
+  // Called once a frame has been committed. Hides all the overlays for the
+  // next frame, ScheduleOverlay shows the ones it uses again. Subsurfaces
+  // are synchronized, so this only takes effect with the next commit of the
+  // window, along with its content.
+  void CommitOverlays();
+
  private:
+  struct PendingFrame;
+  struct PendingPresentation;
+
+  PendingPresentation* RequestPresentationFeedback(wl_surface* surface);
+  void RemovePresentation(PendingPresentation* presentation);
+  void AddSurfaceListener();
+  // Acknowledges the last configure, for the next commit.
+  void AckConfigure();
+  void RestackOverlays();
+  // Runs the completions of the frames the compositor didn't repaint in time.
+  void OnFrameTimeout();
+  gfx::Size GetBufferSize(const gfx::Size& size) const;
+  // Crops the buffer to the window size, when they differ.
+  void UpdateViewport();
+  WaylandScreen* GetCurrentScreen() const;
+  static void OnFrameDone(void* data, wl_callback* callback, uint32_t time);
+  static void OnSyncOutput(void* data,
+                           wp_presentation_feedback* feedback,
+                           wl_output* output);
+  static void OnPresented(void* data,
+                          wp_presentation_feedback* feedback,
+                          uint32_t tv_sec_hi,
+                          uint32_t tv_sec_lo,
+                          uint32_t tv_nsec,
+                          uint32_t refresh,
+                          uint32_t seq_hi,
+                          uint32_t seq_lo,
+                          uint32_t flags);
+  static void OnDiscarded(void* data, wp_presentation_feedback* feedback);
+  static void OnSurfaceEnter(void* data,
+                             wl_surface* surface,
+                             wl_output* output);
+  static void OnSurfaceLeave(void* data,
+                             wl_surface* surface,
+                             wl_output* output);
+
   WaylandShellSurface* shell_surface_;
   EGLWindow* window_;
+  wl_event_queue* queue_;
+  // Frame callback and presentation feedback requested for the next commit.
+  PendingFrame* next_frame_;
+  PendingPresentation* next_presentation_;
+  // Frames swapped but not yet repainted by the compositor, oldest first.
+  std::deque<PendingFrame*> pending_frames_;
+  size_t max_frames_in_flight_;
+  // Set when ThrottleFrames() or a frame completion timed out, until the next
+  // frame callback.
+  bool frames_overdue_;
+  base::OneShotTimer frame_timeout_;
+  // Commits waiting for presentation feedback, oldest first.
+  std::deque<PendingPresentation*> pending_presentations_;
+  base::TimeTicks last_frame_time_;
+  base::TimeDelta presentation_refresh_;
+  uint32_t last_presentation_flags_;
+  wp_viewport* viewport_;
+  int resize_quantum_;
+  gfx::Size buffer_size_;
+  int buffer_reallocations_;
+  // Size the window is rendered at, as set by Resize.
+  gfx::Size render_size_;
+  float render_scale_;
+  float requested_render_scale_;
+  // Size of the window on screen when the render scale isn't 1.
+  gfx::Size logical_size_;
+  std::unique_ptr<WaylandRenderScalePolicy> render_scale_policy_;
+  // Overlay subsurfaces by z order. They are kept around when hidden, as
+  // the same planes are usually used again in the following frames.
+  std::map<int, WaylandSubsurface*> overlays_;
+  // Size of the last configure not yet forwarded, empty if none.
+  gfx::Size pending_configure_size_;
+  // Size of the last configure not yet acknowledged, empty if none.
+  gfx::Size configure_size_;
+  int frames_since_configure_;
+  // The current opaque and input region, NULL if there is none.
+  wl_region* region_;
+  std::vector<gfx::Rect> region_rects_;
+  // Outputs the surface is shown on, in the order it entered them.
+  std::vector<wl_output*> outputs_;
 
   ShellType type_;
   unsigned handle_;
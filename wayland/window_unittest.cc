@@ -0,0 +1,144 @@
+// Copyright 2016 Intel Corporation. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "ozone/wayland/window.h"
+
+#include <memory>
+#include <vector>
+
+#include "ozone/wayland/display.h"
+#include "ozone/wayland/shell/shell_surface.h"
+#include "ozone/wayland/shm_arena.h"
+#include "ozone/wayland/test/fake_compositor.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace ozonewayland {
+
+namespace {
+
+// Stands for the window surface in the stacks returned by GetStackBuffers.
+const uint32_t kWindowSurface = 0xffffffff;
+
+uint32_t GetId(void* proxy) {
+  return wl_proxy_get_id(static_cast<wl_proxy*>(proxy));
+}
+
+}  // namespace
+
+// Runs a WaylandWindow against FakeCompositor, no GPU involved.
+class WaylandWindowOverlayTest : public testing::Test {
+ public:
+  WaylandWindowOverlayTest() : queue_(NULL) {}
+
+  void SetUp() override {
+    ASSERT_TRUE(compositor_.Start());
+    display_.reset(new WaylandDisplay());
+    ASSERT_TRUE(display_->InitializeHardware());
+    ASSERT_TRUE(display_->GetSubcompositor());
+    queue_ = wl_display_create_queue(display_->display());
+
+    window_.reset(new WaylandWindow(1));
+    window_->SetShellAttributes(WaylandWindow::TOPLEVEL);
+  }
+
+  void TearDown() override {
+    window_.reset();
+    for (WaylandShmBuffer* buffer : buffers_)
+      display_->GetShmArena()->DestroyBuffer(buffer);
+    if (queue_)
+      wl_event_queue_destroy(queue_);
+    display_.reset();
+  }
+
+ protected:
+  wl_buffer* CreateBuffer() {
+    WaylandShmBuffer* buffer = display_->GetShmArena()->CreateBuffer(
+        gfx::Size(16, 16), WL_SHM_FORMAT_ARGB8888, queue_);
+    buffers_.push_back(buffer);
+    return buffer->buffer();
+  }
+
+  // Returns once the compositor has handled all the requests made so far.
+  void Sync() {
+    ASSERT_NE(-1, wl_display_roundtrip_queue(display_->display(), queue_));
+  }
+
+  // Returns the buffers shown by the surfaces stacked with the window, from
+  // bottom to top. Hidden overlays show buffer 0.
+  std::vector<uint32_t> GetStackBuffers() {
+    uint32_t window_id = GetId(window_->ShellSurface()->GetWLSurface());
+    std::vector<uint32_t> buffers;
+    for (uint32_t surface_id : compositor_.GetStack(window_id)) {
+      buffers.push_back(surface_id == window_id ?
+          kWindowSurface : compositor_.GetBuffer(surface_id));
+    }
+
+    return buffers;
+  }
+
+  FakeCompositor compositor_;
+  std::unique_ptr<WaylandDisplay> display_;
+  std::unique_ptr<WaylandWindow> window_;
+  wl_event_queue* queue_;
+  std::vector<WaylandShmBuffer*> buffers_;
+};
+
+TEST_F(WaylandWindowOverlayTest, StacksOverlaysByZOrder) {
+  wl_buffer* below2 = CreateBuffer();
+  wl_buffer* below1 = CreateBuffer();
+  wl_buffer* above1 = CreateBuffer();
+  wl_buffer* above2 = CreateBuffer();
+
+  // Positive z orders go above the window, negative ones below, whatever the
+  // order the planes are first used in.
+  window_->ScheduleOverlay(2, above2, gfx::Point());
+  window_->ScheduleOverlay(-1, below1, gfx::Point());
+  window_->ScheduleOverlay(1, above1, gfx::Point(10, 10));
+  window_->ScheduleOverlay(-2, below2, gfx::Point(20, 20));
+  Sync();
+
+  std::vector<uint32_t> expected;
+  expected.push_back(GetId(below2));
+  expected.push_back(GetId(below1));
+  expected.push_back(kWindowSurface);
+  expected.push_back(GetId(above1));
+  expected.push_back(GetId(above2));
+  EXPECT_EQ(expected, GetStackBuffers());
+}
+
+TEST_F(WaylandWindowOverlayTest, CommitOverlaysHidesUnusedOverlays) {
+  wl_buffer* below = CreateBuffer();
+  wl_buffer* above = CreateBuffer();
+
+  window_->ScheduleOverlay(-1, below, gfx::Point());
+  window_->ScheduleOverlay(1, above, gfx::Point());
+  Sync();
+  std::vector<uint32_t> expected;
+  expected.push_back(GetId(below));
+  expected.push_back(kWindowSurface);
+  expected.push_back(GetId(above));
+  EXPECT_EQ(expected, GetStackBuffers());
+
+  // The next frame only uses the plane above the window. The one below is
+  // hidden but kept in the stack for later frames.
+  window_->CommitOverlays();
+  window_->ScheduleOverlay(1, above, gfx::Point());
+  Sync();
+  expected[0] = 0;
+  EXPECT_EQ(expected, GetStackBuffers());
+
+  // Frames without overlays hide all of them.
+  window_->CommitOverlays();
+  Sync();
+  expected[2] = 0;
+  EXPECT_EQ(expected, GetStackBuffers());
+
+  // Planes are reused in place.
+  window_->ScheduleOverlay(-1, below, gfx::Point());
+  Sync();
+  expected[0] = GetId(below);
+  EXPECT_EQ(expected, GetStackBuffers());
+}
+
+}  // namespace ozonewayland